@@ -0,0 +1,464 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: capldll_bench.cpp
+|
+|            Headless benchmark of the CAPL DLL. Loads the shared library
+|            like CANoe does (VIASetService, VIARegisterCDLL, dllInit),
+|            calls its exports from one thread at a fixed rate while the
+|            mocked VIA timers run in the same thread, and reports the
+|            throughput, the latency percentiles and the heap allocations
+|            per call of every export.
+|
+|            The DLL sends to 127.0.0.1:20000, where its own receiver
+|            listens, so the receive path is measured as well. With
+|            --receive timer the receiver runs in the mocked measurement
+|            context instead of its thread (dllSetReceiveMode).
+|
+|            capldll_bench [--dll <path>] [--workload set|get|mixed|frame]
+|                          [--rate <cycles/s>] [--duration <s>]
+|                          [--publish-rate <Hz>] [--wire json|binary]
+|                          [--vehicles <n>] [--receive thread|timer]
+ ----------------------------------------------------------------------------*/
+
+#include <dlfcn.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "via_mock.h"
+
+
+// ============================================================================
+// Allocation counter
+//
+// Replaces the global operator new of the process, the DLL binds to it as
+// well. Only the allocations inside a measured export call are counted.
+// ============================================================================
+static thread_local bool sCountAllocations = false;
+static uint64_t          sAllocations      = 0;
+
+void* operator new(size_t size)
+{
+  if (sCountAllocations)
+  {
+    ++sAllocations;
+  }
+  void* p = malloc(size>0 ? size : 1);
+  if (p==nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+
+static uint64_t sNowNs()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec*1000000000u + (uint64_t)now.tv_nsec;
+}
+
+
+// ============================================================================
+// LatencyHistogram
+//
+// Log-linear histogram with 16 buckets per power of two (6% resolution)
+// up to 2^40 ns.
+// ============================================================================
+class LatencyHistogram
+{
+public:
+  LatencyHistogram() : mBuckets(kBucketCount, 0), mCount(0), mSum(0), mMax(0) {}
+
+  void Record(uint64_t nanoseconds)
+  {
+    ++mBuckets[Index(nanoseconds)];
+    ++mCount;
+    mSum += nanoseconds;
+    if (nanoseconds>mMax)
+    {
+      mMax = nanoseconds;
+    }
+  }
+
+  uint64_t Count() const { return mCount; }
+  uint64_t Max() const   { return mMax; }
+  uint64_t Mean() const  { return (mCount>0) ? mSum / mCount : 0; }
+
+  // Highest value of the bucket that holds the 'fraction' quantile
+  uint64_t Percentile(double fraction) const
+  {
+    uint64_t rank = (uint64_t)(fraction*mCount + 0.5);
+    uint64_t seen = 0;
+    for (uint32_t i=0; i<kBucketCount; ++i)
+    {
+      seen += mBuckets[i];
+      if (seen>=rank && seen>0)
+      {
+        uint64_t value = UpperBound(i);
+        return (value>mMax) ? mMax : value;
+      }
+    }
+    return mMax;
+  }
+
+private:
+  static const uint32_t kSubBits     = 4;
+  static const uint32_t kSubCount    = 1 << kSubBits;
+  static const uint32_t kMaxBits     = 40;
+  static const uint32_t kBucketCount = kSubCount + (kMaxBits - kSubBits)*kSubCount;
+
+  static uint32_t Index(uint64_t value)
+  {
+    if (value<kSubCount)
+    {
+      return (uint32_t)value;
+    }
+    uint32_t msb = 63 - __builtin_clzll(value);
+    if (msb>=kMaxBits)
+    {
+      return kBucketCount - 1;
+    }
+    uint32_t shift = msb - kSubBits;
+    return kSubCount + shift*kSubCount + (uint32_t)((value >> shift) & (kSubCount - 1));
+  }
+
+  static uint64_t UpperBound(uint32_t index)
+  {
+    if (index<kSubCount)
+    {
+      return index;
+    }
+    uint32_t shift = (index - kSubCount) / kSubCount;
+    uint64_t sub   = kSubCount + (index - kSubCount) % kSubCount;
+    return ((sub + 1) << shift) - 1;
+  }
+
+  std::vector<uint64_t> mBuckets;
+  uint64_t              mCount;
+  uint64_t              mSum;
+  uint64_t              mMax;
+};
+
+
+// ============================================================================
+// Exports of the DLL
+// ============================================================================
+typedef void    (*VoidFn)(void);
+typedef void    (*HandleFn)(uint32_t);
+typedef void    (*SetIntFn)(int32_t);
+typedef void    (*SetTextFn)(const char*);
+typedef int32_t (*GetIntFn)(void);
+typedef int32_t (*SetIntStatusFn)(int32_t);
+typedef int32_t (*GetCountersFn)(uint32_t*, int32_t);
+typedef void    (*SetBsmFrameFn)(int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t,
+                                 const char*, int32_t, int32_t, const char*, int32_t, int32_t, int32_t, int32_t,
+                                 int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, const char*,
+                                 int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t, int32_t,
+                                 int32_t, const char*, int32_t);
+
+static CAPL_DLL_INFO4* sTable = nullptr;
+
+static void* sExport(const char* name)
+{
+  for (int32_t i=1; sTable[i].cdlName[0]!=0; ++i)
+  {
+    if (strcmp(sTable[i].cdlName, name)==0)
+    {
+      return (void*)sTable[i].adr;
+    }
+  }
+  fprintf(stderr, "capldll_bench: %s is not exported\n", name);
+  exit(1);
+}
+
+
+// ============================================================================
+// Workloads
+//
+// One cycle of a workload calls every operation once. Each operation is
+// measured on its own.
+// ============================================================================
+struct BenchOp
+{
+  const char*      name;
+  void*            fn;
+  char             kind;          // 'I' set int, 'T' set text, 'G' get, 'F' SetBsmFrame
+  LatencyHistogram latency;
+  uint64_t         allocations;
+};
+
+static void sAddOp(std::vector<BenchOp>& ops, const char* name, char kind)
+{
+  BenchOp op;
+  op.name        = name;
+  op.fn          = sExport(name);
+  op.kind        = kind;
+  op.allocations = 0;
+  ops.push_back(op);
+}
+
+static bool sBuildWorkload(const char* workload, std::vector<BenchOp>& ops)
+{
+  if (strcmp(workload, "set")==0)
+  {
+    sAddOp(ops, "SetLatiude", 'I');
+    sAddOp(ops, "SetLongtitude", 'I');
+    sAddOp(ops, "SetSpeed", 'I');
+    sAddOp(ops, "SetHeading", 'I');
+  }
+  else if (strcmp(workload, "get")==0)
+  {
+    sAddOp(ops, "GetLatiude", 'G');
+    sAddOp(ops, "GetLongtitude", 'G');
+    sAddOp(ops, "GetSpeed", 'G');
+    sAddOp(ops, "GetHeading", 'G');
+  }
+  else if (strcmp(workload, "mixed")==0)
+  {
+    sAddOp(ops, "SetSpeed", 'I');
+    sAddOp(ops, "SetHeading", 'I');
+    sAddOp(ops, "SetEvent", 'T');
+    sAddOp(ops, "GetSpeed", 'G');
+    sAddOp(ops, "GetHeading", 'G');
+  }
+  else if (strcmp(workload, "frame")==0)
+  {
+    sAddOp(ops, "SetBsmFrame", 'F');
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+static void sInvoke(BenchOp& op, uint64_t cycle)
+{
+  int32_t value = (int32_t)(cycle & 0x7fff);
+  switch (op.kind)
+  {
+  case 'I':
+    ((SetIntFn)op.fn)(value);
+    break;
+  case 'T':
+    ((SetTextFn)op.fn)((cycle & 1) ? "0x10" : "0x0");
+    break;
+  case 'G':
+    ((GetIntFn)op.fn)();
+    break;
+  case 'F':
+    ((SetBsmFrameFn)op.fn)(value, value, 1, value, value, 0, 0, 1,
+                           "0x0", 0, 0, "0x1", value, 100, 1, 1,
+                           0, 1, 1, 0, 0, 0, 0, "0x0",
+                           0, 0, 0, 0, 0, 180, 450, 30,
+                           0, "0x0", 0);
+    break;
+  }
+}
+
+
+// ============================================================================
+// main
+// ============================================================================
+struct BenchOptions
+{
+  const char* dll;
+  const char* workload;
+  double      rate;           // cycles per second, 0: as fast as possible
+  double      duration;       // seconds
+  int32_t     publishRate;    // Hz, -1: default of the DLL
+  int32_t     wireFormat;
+  int32_t     vehicles;
+  int32_t     receiveMode;    // 0: receiver thread, 1: VIA timer
+};
+
+static void sUsage()
+{
+  fprintf(stderr,
+          "usage: capldll_bench [--dll <path>] [--workload set|get|mixed|frame]\n"
+          "                     [--rate <cycles/s>] [--duration <s>]\n"
+          "                     [--publish-rate <Hz>] [--wire json|binary] [--vehicles <n>]\n"
+          "                     [--receive thread|timer]\n");
+}
+
+static bool sParseOptions(int argc, char** argv, BenchOptions& options)
+{
+  options.dll         = CAPLDLL_PATH;
+  options.workload    = "mixed";
+  options.rate        = 0;
+  options.duration    = 2;
+  options.publishRate = -1;
+  options.wireFormat  = 0;
+  options.vehicles    = 1;
+  options.receiveMode = 0;
+
+  for (int i=1; i<argc; ++i)
+  {
+    const char* value = (i+1<argc) ? argv[i+1] : nullptr;
+    if (value==nullptr)
+    {
+      return false;
+    }
+    if (strcmp(argv[i], "--dll")==0)                { options.dll         = value; }
+    else if (strcmp(argv[i], "--workload")==0)      { options.workload    = value; }
+    else if (strcmp(argv[i], "--rate")==0)          { options.rate        = atof(value); }
+    else if (strcmp(argv[i], "--duration")==0)      { options.duration    = atof(value); }
+    else if (strcmp(argv[i], "--publish-rate")==0)  { options.publishRate = atoi(value); }
+    else if (strcmp(argv[i], "--wire")==0)          { options.wireFormat  = (strcmp(value, "binary")==0) ? 1 : 0; }
+    else if (strcmp(argv[i], "--vehicles")==0)      { options.vehicles    = atoi(value); }
+    else if (strcmp(argv[i], "--receive")==0)       { options.receiveMode = (strcmp(value, "timer")==0) ? 1 : 0; }
+    else
+    {
+      return false;
+    }
+    ++i;
+  }
+  return options.duration>0 && options.vehicles>0;
+}
+
+int main(int argc, char** argv)
+{
+  BenchOptions options;
+  if (!sParseOptions(argc, argv, options))
+  {
+    sUsage();
+    return 2;
+  }
+
+  void* library = dlopen(options.dll, RTLD_NOW);
+  if (library==nullptr)
+  {
+    fprintf(stderr, "capldll_bench: %s\n", dlerror());
+    return 1;
+  }
+  CAPL_DLL_INFO4** table     = (CAPL_DLL_INFO4**)dlsym(library, "caplDllTable4");
+  void (*setService)(VIAService*) = (void (*)(VIAService*))dlsym(library, "VIASetService");
+  void (*registerCdll)(VIACapl*)  = (void (*)(VIACapl*))dlsym(library, "VIARegisterCDLL");
+  if (table==nullptr || setService==nullptr || registerCdll==nullptr)
+  {
+    fprintf(stderr, "capldll_bench: %s is no CAPL DLL\n", options.dll);
+    return 1;
+  }
+  sTable = *table;
+
+  std::vector<BenchOp> ops;
+  if (!sBuildWorkload(options.workload, ops))
+  {
+    sUsage();
+    return 2;
+  }
+
+  // CANoe order: service, CAPL block, dllInit
+  const uint32_t kHandle = 1;
+  MockService service;
+  MockCapl    capl(kHandle);
+  setService(&service);
+  registerCdll(&capl);
+  // before dllInit, which starts the receiver
+  if (((SetIntStatusFn)sExport("dllSetReceiveMode"))(options.receiveMode)!=0)
+  {
+    fprintf(stderr, "capldll_bench: receive mode not supported\n");
+    return 1;
+  }
+  ((HandleFn)sExport("dllInit"))(kHandle);
+  if (options.publishRate>=0)
+  {
+    ((SetIntFn)sExport("dllSetPublishRate"))(options.publishRate);
+  }
+  ((SetIntFn)sExport("dllSetWireFormat"))(options.wireFormat);
+  ((SetIntFn)sExport("dllSetMultiVehicle"))(options.vehicles>1 ? 1 : 0);
+  ((VoidFn)sExport("dllResetStats"))();
+
+  std::vector<std::string> ids;
+  for (int32_t i=0; i<options.vehicles; ++i)
+  {
+    char id[16];
+    snprintf(id, sizeof(id), "0x%x", i+1);
+    ids.push_back(id);
+  }
+  SetTextFn setId = (SetTextFn)sExport("SetId");
+
+  uint64_t start    = sNowNs();
+  uint64_t duration = (uint64_t)(options.duration*1e9);
+  uint64_t now      = start;
+  uint64_t cycle    = 0;
+  for (; now-start<duration; ++cycle)
+  {
+    if (options.rate>0)
+    {
+      uint64_t deadline = start + (uint64_t)(cycle*1e9/options.rate);
+      while ((now = sNowNs())<deadline)
+      {
+        service.RunTimers((VIATime)(now-start));
+        if (deadline-now>200000)
+        {
+          timespec pause = { 0, 100000 };
+          nanosleep(&pause, nullptr);
+        }
+      }
+    }
+
+    if (options.vehicles>1)
+    {
+      setId(ids[cycle % ids.size()].c_str());
+    }
+    for (size_t i=0; i<ops.size(); ++i)
+    {
+      BenchOp& op = ops[i];
+      uint64_t allocations = sAllocations;
+      uint64_t t0 = sNowNs();
+      sCountAllocations = true;
+      sInvoke(op, cycle);
+      sCountAllocations = false;
+      uint64_t t1 = sNowNs();
+      op.latency.Record(t1 - t0);
+      op.allocations += sAllocations - allocations;
+    }
+
+    now = sNowNs();
+    service.RunTimers((VIATime)(now-start));
+  }
+  double elapsed = (now-start)*1e-9;
+
+  printf("workload %s, %llu cycles in %.3f s\n", options.workload, (unsigned long long)cycle, elapsed);
+  printf("%-16s %10s %12s %9s %9s %9s %9s %12s\n",
+         "export", "calls", "calls/s", "p50_ns", "p99_ns", "p999_ns", "max_ns", "allocs/call");
+  for (size_t i=0; i<ops.size(); ++i)
+  {
+    const BenchOp& op = ops[i];
+    uint64_t calls = op.latency.Count();
+    printf("%-16s %10llu %12.0f %9llu %9llu %9llu %9llu %12.3f\n", op.name,
+           (unsigned long long)calls, calls/elapsed,
+           (unsigned long long)op.latency.Percentile(0.5),
+           (unsigned long long)op.latency.Percentile(0.99),
+           (unsigned long long)op.latency.Percentile(0.999),
+           (unsigned long long)op.latency.Max(),
+           (calls>0) ? (double)op.allocations/calls : 0.0);
+  }
+
+  const std::list<MockTimer*>& timers = service.Timers();
+  for (std::list<MockTimer*>::const_iterator lIter=timers.begin(); lIter!=timers.end(); ++lIter)
+  {
+    printf("timer %-16s fired %llu\n", (*lIter)->Name().c_str(), (unsigned long long)(*lIter)->Fired());
+  }
+  printf("CALLBACK_OnBsm   calls %llu\n", (unsigned long long)capl.OnBsm().Calls());
+
+  uint32_t counters[6] = { 0 };
+  ((GetCountersFn)sExport("dllGetCounters"))(counters, 6);
+  printf("sent %u datagrams (%u bytes, %u errors), received %u datagrams (%u bytes, %u parse failures)\n",
+         counters[1], counters[0], counters[2], counters[4], counters[3], counters[5]);
+
+  ((HandleFn)sExport("dllEnd"))(kHandle);
+  dlclose(library);
+  return 0;
+}
@@ -0,0 +1,291 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: via_mock.h
+|
+|            Minimal CANoe side of the VIA interfaces for running the CAPL
+|            DLL without CANoe: one CAPL block (VIACapl), its callback
+|            functions (VIACaplFunction) and a VIA service whose timers
+|            are fired by the caller, like the measurement context of
+|            CANoe does. Everything else of VIAService is not supported.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <list>
+#include <string>
+#include <string.h>
+
+#include "../Includes/cdll.h"
+#include "../Includes/VIA.h"
+#include "../Includes/VIA_CDLL.h"
+
+
+// ============================================================================
+// MockCaplFunction
+//
+// A CAPL callback with signature 'rtype' and 'ptypes' that only counts
+// its calls.
+// ============================================================================
+class MockCaplFunction : public VIACaplFunction
+{
+public:
+  MockCaplFunction(const char* name, char rtype, const char* ptypes)
+   : mName(name), mResultType(rtype), mParamTypes(ptypes), mCalls(0)
+  {}
+
+  const std::string& Name() const  { return mName; }
+  uint64_t           Calls() const { return mCalls; }
+
+  VIASTDDECL ParamSize(int32* size)            { *size = 4*(int32)mParamTypes.size(); return kVIA_OK; }
+  VIASTDDECL ParamCount(int32* size)           { *size = (int32)mParamTypes.size(); return kVIA_OK; }
+  VIASTDDECL ParamType(char* type, int32 nth)
+  {
+    if (nth<0 || nth>=(int32)mParamTypes.size())
+    {
+      return kVIA_ParameterInvalid;
+    }
+    *type = mParamTypes[nth];
+    return kVIA_OK;
+  }
+  VIASTDDECL ResultType(char* type)            { *type = mResultType; return kVIA_OK; }
+  VIASTDDECL Call(uint32* result, void* /*params*/)
+  {
+    ++mCalls;
+    *result = 0;
+    return kVIA_OK;
+  }
+  VIASTDDECL CallReturnsDouble(double* result, void* /*params*/)
+  {
+    ++mCalls;
+    *result = 0;
+    return kVIA_OK;
+  }
+
+private:
+  std::string mName;
+  char        mResultType;
+  std::string mParamTypes;
+  uint64_t    mCalls;
+};
+
+
+// ============================================================================
+// MockCapl
+//
+// One CAPL block with the handle 'handle' that provides CALLBACK_OnBsm,
+// the other callbacks of the DLL are reported as missing.
+// ============================================================================
+class MockCapl : public VIACapl
+{
+public:
+  explicit MockCapl(uint32 handle)
+   : mHandle(handle), mOnBsm("CALLBACK_OnBsm", 'V', "D")
+  {}
+
+  const MockCaplFunction& OnBsm() const { return mOnBsm; }
+
+  VIASTDDECL GetVersion(int32* major, int32* minor) { *major = VIAMajorVersion; *minor = VIAMinorVersion; return kVIA_OK; }
+  VIASTDDECL GetCaplHandle(uint32* handle)          { *handle = mHandle; return kVIA_OK; }
+  VIASTDDECL GetCaplFunction(VIACaplFunction** caplfct, const char* name)
+  {
+    if (mOnBsm.Name()==name)
+    {
+      *caplfct = &mOnBsm;
+      return kVIA_OK;
+    }
+    *caplfct = nullptr;
+    return kVIA_ObjectNotFound;
+  }
+  VIASTDDECL ReleaseCaplFunction(VIACaplFunction* /*caplfct*/) { return kVIA_OK; }
+
+private:
+  uint32           mHandle;
+  MockCaplFunction mOnBsm;
+};
+
+
+// ============================================================================
+// MockTimer
+// ============================================================================
+class MockTimer : public VIATimer
+{
+public:
+  // 'clock' is the simulated time of the service
+  MockTimer(const VIATime& clock, VIAOnTimerSink* sink, const char* name)
+   : mClock(clock), mSink(sink), mName(name!=nullptr ? name : ""), mDue(-1), mFired(0)
+  {}
+  // VIATimer has no virtual destructor, MockService deletes MockTimer only
+  virtual ~MockTimer() {}
+
+  // Calls the sink if the timer is due
+  void Run()
+  {
+    if (mDue<0 || mClock<mDue || mSink==nullptr)
+    {
+      return;
+    }
+    VIATime due = mDue;
+    mDue = -1;                 // one-shot, the sink may set it again
+    ++mFired;
+    mSink->OnTimer(due);
+  }
+
+  const std::string& Name() const  { return mName; }
+  uint64_t           Fired() const { return mFired; }
+
+  VIASTDDECL SetSink(VIAOnTimerSink* sink)   { mSink = sink; return kVIA_OK; }
+  VIASTDDECL SetName(const char* name)       { mName = name; return kVIA_OK; }
+  VIASTDDECL SetTimer(VIATime nanoseconds)   { mDue = mClock + nanoseconds; return kVIA_OK; }
+  VIASTDDECL CancelTimer()                   { mDue = -1; return kVIA_OK; }
+
+private:
+  const VIATime&  mClock;
+  VIAOnTimerSink* mSink;
+  std::string     mName;
+  VIATime         mDue;
+  uint64_t        mFired;
+};
+
+
+#define VIA_MOCK_UNSUPPORTED { return kVIA_ServiceNotRunning; }
+
+// ============================================================================
+// MockService
+//
+// Timers run in simulated time, which the caller advances by RunTimers
+// from the thread that plays the measurement context.
+// ============================================================================
+class MockService : public VIAService
+{
+public:
+  MockService() : mNow(0) {}
+  ~MockService()
+  {
+    for (std::list<MockTimer*>::iterator lIter=mTimers.begin(); lIter!=mTimers.end(); ++lIter)
+    {
+      delete *lIter;
+    }
+  }
+
+  // Advances the simulated time to 'now' and fires the due timers
+  void RunTimers(VIATime now)
+  {
+    mNow = now;
+    for (std::list<MockTimer*>::iterator lIter=mTimers.begin(); lIter!=mTimers.end(); ++lIter)
+    {
+      (*lIter)->Run();
+    }
+  }
+
+  const std::list<MockTimer*>& Timers() const { return mTimers; }
+
+  VIASTDDECL GetVersion(int32* major, int32* minor, int32* patchlevel)
+  {
+    *major      = VIAMajorVersion;
+    *minor      = VIAMinorVersion;
+    *patchlevel = 0;
+    return kVIA_OK;
+  }
+  VIASTDDECL CreateTimer(VIATimer** timer, VIANode* /*node*/, VIAOnTimerSink* sink, const char* name)
+  {
+    MockTimer* created = new MockTimer(mNow, sink, name);
+    mTimers.push_back(created);
+    *timer = created;
+    return kVIA_OK;
+  }
+  VIASTDDECL ReleaseTimer(VIATimer* timer)
+  {
+    mTimers.remove((MockTimer*)timer);
+    delete (MockTimer*)timer;
+    return kVIA_OK;
+  }
+  VIASTDDECL GetCurrentSimTime(VIATime* time) { *time = mNow; return kVIA_OK; }
+  VIASTDDECL WriteString(const char* /*text*/) { return kVIA_OK; }
+
+  // not supported
+  VIASTDDECL GetClientWindow(void** /*handle*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetConfigItem(uint32 /*topic*/, uint32 /*subtopic*/, char* /*buffer*/, int32 /*bufferLength*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetDBAttributeType(uint32* /*attributeType*/, uint32 /*objectType*/, const char* /*objectName*/, const char* /*attrName*/, const char* /*dbName*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetDBAttributeValue(double* /*attributeValue*/, uint32 /*objectType*/, const char* /*objectName*/, const char* /*attrName*/, const char* /*dbName*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetDBAttributeString(char* /*buffer*/, int32 /*bufferLength*/, uint32 /*objectType*/, const char* /*objectName*/, const char* /*attrName*/, const char* /*dbName*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetEnvVar(VIAEnvVar** /*ev*/, VIANode* /*node*/, const char* /*name*/, VIAOnEnvVar* /*sink*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseEnvVar(VIAEnvVar* /*ev*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetBusInterface(VIABus** /*busInterface*/, VIANode* /*node*/, uint32 /*interfaceType*/, int32 /*majorversion*/, int32 /*minorversion*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseBusInterface(VIABus* /*busInterface*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetUtilService(VIAUtil** /*service*/, int32 /*majorversion*/, int32 /*minorversion*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseUtilService(VIAUtil* /*service*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL WriteToLog(const char* /*text*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL Assertion(char* /*message*/, char* /*condition*/, char* /*file*/, int32 /*line*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL MsgBox(char* /*message*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL RtKernelIsRunning() VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetCurrentNode(VIANode** /*node*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetCurrentNodeLayer(VIANodeLayerApi** /*nodelayer*/, VIAModuleApi* /*module*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL Stop() VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSystemFiber(void** /*fiber*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetServiceFlags(uint32* /*flags*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL CreateWriteTab(uint32* /*aSink*/, const char* /*aSinkName*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseWriteTab(uint32 /*aSink*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL WriteStringToTab(uint32 /*aSink*/, VIAWriteSeverity /*aSeverity*/, const char* /*aText*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetTestControlApi(VIATestControlApi** /*apTestControlObject*/, VIANode* /*node*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseTestControlApi(VIATestControlApi* /*apTestControlObject*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ClearWriteTab(uint32 /*aSink*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL SetNLServiceApi(VIANLServiceApi* /*apNLServiceMember*/, VIANode* /*apMyNode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ProvideNLService(int8 /*aMultiUserService*/, VIANLService* /*apServiceToProvide*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceProvider*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL AcquireNLService(const char* /*apServiceName*/, int32 /*aInterfaceVersion*/, VIANLService** /*appService*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceUser*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL CancelNLService(VIANLService* /*apServiceToCancel*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceProvider*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseNLService(VIANLService* /*apServiceToRelease*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceUser*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSignalAccessApi(VIASignalAccessApi** /*aSignalAccessApi*/, VIANode* /*aNode*/, int32 /*majorversion*/, int32 /*minorversion*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSystemVariablesRootNamespace(VIANamespace*& /*nameSpace*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL RegisterSystemVariablesClient(VIASysVarClientHandle /*handle*/, const char* /*description*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL UnregisterSystemVariablesClient(VIASysVarClientHandle /*handle*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetDatabaseIterator(VIDBDatabaseIterator** /*iterator*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL DebugBreak() VIA_MOCK_UNSUPPORTED
+  VIASTDDECL IsSimulated(int32* /*simulated*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSocketService(VIASocketService** /*ppService*/, VIANode* /*pNode*/, VIASocketServiceType /*type*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseSocketService(VIASocketService* /*pService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL NotifyDiagnosticEvent(VIAProtocolType /*type*/, void* /*params*/, int32 /*request*/, int8 /*buffer*/[], uint32 /*size*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetDiagDescription(const char* /*aEcuQualifier_in*/, char* /*apEcuId_out*/, int32 /*aLenEcuId*/, char* /*apVariantQualifier_out*/, int32 /*aLenVariantQualifier*/, char* /*apLanguage_out*/, int32 /*aLenLanguage*/, char* /*apPath_out*/, int32 /*aLenPath*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSerialService(VIASerialService** /*ppService*/, VIANode* /*pNode*/, VIASerialServiceType /*type*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseSerialService(VIASerialService* /*pService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetUserFilePath(const char* /*filename*/, char* /*pathBuffer*/, int32 /*pathBufferLength*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSystemVariablesDefaultClientHandle(VIASysVarClientHandle* /*handle*/, VIAModuleApi* /*module*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL RegisterUserFile(const char* /*filePath*/, bool /*isTempRegistration*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL IncrementTimerBase(VIATime /*newTimeBaseTicks*/, int32 /*numberOfTicks*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL IsSlaveMode(bool* /*isSlaveMode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetCAPLonBoardConstruction(VIACAPLonBoardConstruction** /*cob*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseCAPLonBoardConstruction(VIACAPLonBoardConstruction* /*cob*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetTestApi(VIATestApi** /*apTestApi*/, VIANode* /*pNode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseTestApi(VIATestApi* /*apTestApi*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSocketServiceEx(VIASocketServiceEx** /*ppService*/, VIANode* /*pNode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseSocketServiceEx(VIASocketServiceEx* /*pService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetParameterServerService(VIAParameterServerService** /*pVIAParameterServerService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL SetNLServiceApi2(VIANLServiceApi* /*apNLServiceMember*/, VIANode* /*apMyNode*/, VIANLServiceExecutionMode /*execMode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ProvideNLService2(int8 /*aMultiUserService*/, VIANLService* /*apServiceToProvide*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceProvider*/, VIANLServiceExecutionMode /*execMode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL AcquireNLService2(const char* /*apServiceName*/, int32 /*aInterfaceVersion*/, VIANLService** /*appService*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceUser*/, VIANLServiceExecutionMode /*execMode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL CancelNLService2(VIANLService* /*apServiceToCancel*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceProvider*/, VIANLServiceExecutionMode /*execMode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseNLService2(VIANLService* /*apServiceToRelease*/, VIANode* /*apMyNode*/, VIANLServiceApi* /*apNLServiceUser*/, VIANLServiceExecutionMode /*execMode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSynchronizedFilePath(const char* /*filename*/, char* /*pathBuffer*/, uint32 /*pathBufferLength*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetMediaService(VIAMediaService** /*ppService*/, VIANode* /*pNode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseMediaService(VIAMediaService* /*pService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetCurrentClient(void** /*pClient*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetClient(VIANode* /*pNode*/, void** /*pClient*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL SetCurrentClient(void* /*pClient*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetBusContext(VIANode* /*pNode*/, uint32* /*channelType*/, uint32* /*channelNumber*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL SetBusContext(VIANode* /*pNode*/, uint32 /*channelType*/, uint32 /*channelNumber*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetFunctionBusService(VIAFbViaService** /*outFbViaService*/, int32 /*majorversion*/, int32 /*minorversion*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseFunctionBusService(VIAFbViaService* /*inFbViaService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL RegisterCoreProcessingFunction(ICoreProcessingFunction* /*fct*/, bool /*once*/, uint32* /*handle*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL UnregisterCoreProcessingFunction(uint32 /*handle*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSocketService2(VIASocketService2** /*ppService*/, VIANode* /*pNode*/, VIASocketServiceType /*type*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseSocketService2(VIASocketService2* /*pService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetSocketServiceEx2(VIASocketServiceEx2** /*ppService*/, VIANode* /*pNode*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL ReleaseSocketServiceEx2(VIASocketServiceEx2* /*pService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetFBDataModelIterator(VIDBDatabaseIterator** /*iterator*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL GetDebugInfoService(VIADebugInfoService** /*ppService*/) VIA_MOCK_UNSUPPORTED
+  VIASTDDECL IsValidLicense(uint32 /*productCode*/, uint32 /*productVersionMajor*/, uint32 /*productVersionMinor*/) VIA_MOCK_UNSUPPORTED
+
+private:
+  VIATime               mNow;
+  std::list<MockTimer*> mTimers;
+};
+
+#undef VIA_MOCK_UNSUPPORTED
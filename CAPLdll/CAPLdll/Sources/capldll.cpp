@@ -32,25 +32,44 @@
 #define USECDLL_FEATURE
 #define _BUILDNODELAYERDLL
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <string.h>
+#include <stdlib.h>
 #include "../Includes/cdll.h"
 #include "../Includes/VIA.h"
 #include "../Includes/VIA_CDLL.h"
 
-#include "json.h"
-#include <WinSock2.h>
-#pragma comment(lib,"ws2_32.lib")
-#pragma comment(lib,"json_vc71_libmtd.lib")
+#include "v2x_socket.h"
+#include "v2x_receiver.h"
+#include "v2x_frame.h"
+#include "v2x_json.h"
+#include "v2x_vehicle.h"
+#include "v2x_handle_table.h"
+#include "v2x_stats.h"
+#include "v2x_shm.h"
+#include "v2x_record.h"
+#include "v2x_sysvar.h"
+#include "v2x_signal_map.h"
+#include "v2x_capl_call.h"
 
 
 #if defined(_WIN64) || defined(__linux__)
   #define X64
 #endif
 
+// VS 2013 has no thread_local yet
+#if defined(_MSC_VER) && _MSC_VER<1900
+  #define V2X_THREAD_LOCAL __declspec(thread)
+#else
+  #define V2X_THREAD_LOCAL thread_local
+#endif
+
 
 class CaplInstanceData;
-typedef std::map<uint32_t, CaplInstanceData*> VCaplMap;
-typedef std::map<uint32_t, VIACapl*> VServiceMap;
+typedef V2XHandleTable<CaplInstanceData> VCaplTable;
+typedef V2XHandleTable<VIACapl>          VServiceTable;
 
 
 // ============================================================================
@@ -60,8 +79,236 @@ typedef std::map<uint32_t, VIACapl*> VServiceMap;
 static uint32_t data = 0;
 static char dlldata[100];
 
-VCaplMap    gCaplMap;
-VServiceMap gServiceMap;
+VCaplTable    gCaplTable;
+VServiceTable gServiceTable;
+
+// serializes dllInit, dllEnd, the exports that change state shared by all
+// CAPL blocks (gDefaultConfig, receiver, capture, replay) and those that
+// change the transport or signal map of a CAPL block, so dllEnd cannot
+// delete the block under them
+std::mutex    gInitMutex;
+
+// destination of the V2X data sent to the ROS/OBU bridge
+int Port = 20000;
+const char* addr = "127.0.0.1";
+
+// local port the receiver thread listens on for V2X data from the bridge
+int RecvPort = 20000;
+
+// one receiver thread per DLL, feeds the Get* functions
+V2XReceiver gReceiver;
+
+// age in ms after which Get*Ex report a received value as stale, see
+// dllSetStaleAge
+std::atomic<int32_t> gStaleAgeMs(1000);
+
+// copies the received fields into system variables, see dllSetSysVarNamespace
+V2XSysVarMirror gSysVarMirror;
+
+// VIA service of CANoe, nullptr if VIASetService was not called
+VIAService* gVIAService = nullptr;
+
+// period of the timer that delivers received messages to CALLBACK_OnBsm
+static const int32_t kDispatchPeriodMs = 1;
+
+// wire format of the sent BSM, receivers accept both
+enum V2XWireFormat
+{
+  kWireJson   = 0,   // JSON document, readable for debugging
+  kWireBinary = 1    // fixed layout frame, see v2x_frame.h
+};
+
+// ============================================================================
+// V2XSendConfig
+//
+// Send options of a CAPL block, set by the dllSet* functions. They apply
+// to the current CAPL block and, through gDefaultConfig, to the blocks
+// initialized later.
+// ============================================================================
+struct V2XSendConfig
+{
+  // rate of the periodic BSM frame, 0 sends a frame on every setter call
+  int  PublishRateHz;
+  // send changes of event fields at once instead of waiting for the next frame
+  bool PublishEventsImmediately;
+  // delta protocol: every n-th message is a keyframe, 0 sends the whole
+  // document every time without sequence number
+  int  KeyframeInterval;
+  // V2XWireFormat
+  int  WireFormat;
+  // one BSM per vehicle id instead of a single BSM, see v2x_vehicle.h
+  bool MultiVehicle;
+  // SO_SNDBUF of the transport in bytes
+  int  SendBufferSize;
+  // link header in front of every datagram, see v2x_link.h
+  bool LinkHeader;
+};
+
+V2XSendConfig gDefaultConfig = { 10, true, 0, kWireJson, false, V2XTransport::kDefaultSendBufferSize, false };
+
+
+// ============================================================================
+// V2XTimer
+//
+// Periodic VIA timer of the classes below. The callback runs in the
+// measurement context with the simulated time of the tick and returns
+// false to end the series. Without a VIA service Start() fails and the
+// owners fall back to calls from CAPL.
+// ============================================================================
+class V2XTimer : public VIAOnTimerSink
+{
+public:
+  typedef bool (*Callback)(void* context, VIATime now);
+
+  V2XTimer(const char* name, Callback callback, void* context);
+
+  // (Re)starts the timer with 'period', returns false without VIA service
+  bool Start(VIATime period);
+  void Stop();
+  // Created and not stopped, also after the callback ended the series
+  bool IsRunning() const { return mTimer!=nullptr; }
+
+  VIASTDDECL OnTimer(VIATime nanoseconds);
+
+private:
+  V2XTimer(const V2XTimer&);                   // not copyable
+  V2XTimer& operator=(const V2XTimer&);
+
+  const char* mName;
+  Callback    mCallback;
+  void*       mContext;
+  VIATimer*   mTimer;
+  VIATime     mPeriod;
+};
+
+
+// ============================================================================
+// V2XDispatcher
+//
+// Delivers received V2X messages to the CAPL callback CALLBACK_OnBsm of
+// one CAPL block. CAPL functions may only be called in the measurement
+// context, so the receiver thread just advances its sequence number and a
+// VIA timer checks it once per tick. Without a VIA service
+// (VIASetService not called) CAPL can trigger the delivery itself by
+// dllDispatchBsm.
+// ============================================================================
+class V2XDispatcher
+{
+public:
+  V2XDispatcher(CaplInstanceData& owner);
+
+  void Start();
+  void Stop();
+  // Calls CALLBACK_OnBsm of the owner if a new message arrived
+  void Dispatch();
+
+private:
+  static bool sTick(void* context, VIATime);
+
+  CaplInstanceData& mOwner;
+  V2XTimer          mTimer;
+  uint32_t          mSequence;
+};
+
+
+// ============================================================================
+// V2XPublisher
+//
+// Sends the BSMs built by the Set* functions as one frame per vehicle and
+// timer tick, so the packet rate no longer depends on how often CAPL calls
+// the setters. Without a VIA service the setters send directly.
+// ============================================================================
+class V2XPublisher
+{
+public:
+  V2XPublisher(CaplInstanceData& owner);
+
+  // (Re)starts the timer, a rate of 0 stops it
+  void Start(int32_t rateHz);
+  void Stop();
+  bool IsRunning() const { return mTimer.IsRunning(); }
+
+private:
+  static bool sTick(void* context, VIATime);
+
+  CaplInstanceData& mOwner;
+  V2XTimer          mTimer;
+};
+
+
+// ============================================================================
+// V2XReplayer
+//
+// Feeds the received datagrams of a capture log (see v2x_record.h) into
+// the receiver, so the Get* functions and CALLBACK_OnBsm see the recorded
+// session. It runs on a VIA timer in simulated time, so a measurement in
+// simulated mode replays faster than wall-clock time at any speed. Live
+// datagrams are not published while a replay runs.
+// ============================================================================
+class V2XReplayer
+{
+public:
+  V2XReplayer();
+
+  // Replays 'path' from 'startMs' into the log on at 'speed' times the
+  // recorded rate, 0 replays one datagram per tick regardless of the
+  // recorded times
+  bool Start(const char* path, int32_t speed, uint32_t startMs);
+  void Stop();
+  bool IsRunning() const { return mTimer.IsRunning() && !mFinished; }
+
+private:
+  static bool sTick(void* context, VIATime now);
+  bool Tick(VIATime now);
+  void Finish();
+
+  V2XLogReader mLog;
+  V2XTimer     mTimer;
+  int32_t      mSpeed;
+  uint64_t     mLogStart;      // log time replayed at the first tick
+  VIATime      mSimStart;      // simulated time of the first tick, -1 before
+  bool         mFinished;
+};
+
+// one replay per DLL, like the receiver it feeds
+V2XReplayer gReplayer;
+
+
+// ============================================================================
+// V2XPoller
+//
+// Receive mode kReceiveTimer: the receiver has no thread, this VIA timer
+// takes the waiting datagrams once per tick in the measurement context and
+// calls CALLBACK_OnBsm in the same tick. In simulated time the datagrams
+// are taken at fixed points of the simulation and no receive call blocks.
+// Without a VIA service dllDispatchBsm polls.
+// ============================================================================
+enum V2XReceiveMode
+{
+  kReceiveThread = 0,   // receiver thread, see v2x_receiver.h
+  kReceiveTimer  = 1    // polled by V2XPoller in the measurement context
+};
+
+class V2XPoller
+{
+public:
+  V2XPoller();
+
+  void Start();
+  void Stop();
+
+private:
+  static bool sTick(void* context, VIATime);
+
+  V2XTimer mTimer;
+};
+
+// datagrams taken per tick, the rest waits in SO_RCVBUF for the next one
+static const int32_t kPollDatagramsPerTick = 256;
+
+// V2XReceiveMode of the receiver, see dllSetReceiveMode
+int32_t   gReceiveMode = kReceiveThread;
+V2XPoller gPoller;
 
 
 // ============================================================================
@@ -78,348 +325,1203 @@ class CaplInstanceData
 public:
   CaplInstanceData(VIACapl* capl);
 
-  void GetCallbackFunctions();
-  void ReleaseCallbackFunctions();
+  void GetCallbackFunctions();
+  void ReleaseCallbackFunctions();
+
+  // Definition of the class function.
+  // This class function will call the CAPL callback functions
+  uint32_t ShowValue(uint32_t x);
+  uint32_t ShowDates(int16_t x, uint32_t y, int16_t z);
+  void     DllInfo(const char* x);
+  void     ArrayValues(uint32_t flags, uint32_t numberOfDatabytes, uint8_t databytes[], uint8_t controlcode);
+  void     DllVersion(const char* y);
+  void     OnBsm(uint32_t sequence);
+
+  // UDP transport towards the ROS/OBU bridge, kept open from dllInit to dllEnd
+  bool     OpenTransport(const char* addr, uint16_t port);
+  void     CloseTransport();
+  int32_t  Send(const void* data, size_t length);
+  int32_t  SendBatch(const V2XDatagram* datagrams, size_t count);
+  // Unicast fan-out list or multicast group instead of addr:Port, an empty
+  // list goes back to addr:Port, see V2XTransport::SetDestinations
+  int32_t  SetDestinations(const char* destinations);
+  bool     SetMulticast(int32_t ttl, bool loopback, const char* interfaceAddr);
+  // Shared memory ring instead of UDP for a bridge on the same host, an
+  // empty name goes back to UDP
+  bool     OpenRing(const char* name, uint32_t slots);
+
+  // V2X send side, started by dllInit and stopped by dllEnd
+  void     StartV2X();
+  void     StopV2X();
+  V2XSendConfig&   Config()    { return mConfig; }
+  V2XVehicleTable& Vehicles()  { return mVehicles; }
+  V2XSignalMap&    SignalMap() { return mSignalMap; }
+  void     SetPublishRate(int32_t rateHz);
+  void     SetSendBufferSize(int32_t bytes);
+  void     SetLinkHeader(bool enable);
+  // Makes the vehicle 'id' current, in the multi-vehicle mode only
+  void     SelectVehicle(const char* id);
+  // Back to the single vehicle mode, only the current vehicle is kept
+  void     ResetVehicles();
+  // Called by the setters after 'fields' of the current vehicle were
+  // updated. While the periodic publisher runs the change goes out with
+  // the next frame, event fields may be sent at once.
+  void     BsmChanged(V2XBsmMask fields, bool isEvent);
+  // Sends the message of the current vehicle resp. of all vehicles
+  void     PublishCurrent();
+  void     PublishAll();
+  void     DispatchBsm();
+
+private:
+  // V2XWireFormat of the sent BSMs, the ring always carries binary frames
+  int      WireFormat() const { return mRing.IsOpen() ? (int)kWireBinary : mConfig.WireFormat; }
+
+  // Handles of the CAPL callback functions, typed by their CAPL signature
+  V2XCaplFunction<uint32_t(uint32_t)>                                mShowValue;
+  V2XCaplFunction<uint32_t(int16_t, uint32_t, int16_t)>              mShowDates;
+  V2XCaplFunction<void(V2XCaplArray<char>)>                          mDllInfo;
+  V2XCaplFunction<void(uint32_t, V2XCaplArray<uint8_t>, uint8_t)>    mArrayValues;
+  V2XCaplFunction<void(V2XCaplArray<char>)>                          mDllVersion;
+  V2XCaplFunction<void(uint32_t)>                                    mOnBsm;
+
+  VIACapl*          mCapl;
+
+  V2XTransport      mTransport;
+  V2XShmRing        mRing;
+  V2XSendConfig     mConfig;
+  V2XVehicleTable   mVehicles;
+  V2XSignalMap      mSignalMap;
+  V2XPublisher      mPublisher;
+  V2XDispatcher     mDispatcher;
+
+  // datagrams of one sendmmsg batch of PublishAll
+  char              mBatchBuffer[V2XTransport::kMaxBatch][kBsmJsonMaxSize];
+};
+
+
+CaplInstanceData::CaplInstanceData(VIACapl* capl)
+  // The CAPL callback handles start invalid, see GetCallbackFunctions
+ : mCapl(capl),
+   mConfig(gDefaultConfig),
+   mPublisher(*this),
+   mDispatcher(*this)
+{}
+
+void CaplInstanceData::GetCallbackFunctions()
+{
+  // Get a CAPL function handle. The handle stays valid until end of
+  // measurement or a call of ReleaseCaplFunction. A function that CAPL does
+  // not define with the signature of the handle is not called.
+  mShowValue.Get(mCapl, "CALLBACK_ShowValue");
+  mShowDates.Get(mCapl, "CALLBACK_ShowDates");
+  mDllInfo.Get(mCapl, "CALLBACK_DllInfo");
+  mArrayValues.Get(mCapl, "CALLBACK_ArrayValues");
+  mDllVersion.Get(mCapl, "CALLBACK_DllVersion");
+  mOnBsm.Get(mCapl, "CALLBACK_OnBsm");
+}
+
+void CaplInstanceData::ReleaseCallbackFunctions()
+{
+  // Release all the requested Callback functions
+  mShowValue.Release();
+  mShowDates.Release();
+  mDllInfo.Release();
+  mArrayValues.Release();
+  mDllVersion.Release();
+  mOnBsm.Release();
+}
+
+void CaplInstanceData::DllVersion(const char* y)
+{
+  mDllVersion(nullptr, V2XCaplString(y));
+}
+
+
+uint32_t CaplInstanceData::ShowValue(uint32_t x)
+{
+  uint32_t result;
+  if (mShowValue(&result, x)==kVIA_OK)
+  {
+    return result;
+  }
+  return -1;
+}
+
+uint32_t CaplInstanceData::ShowDates(int16_t x, uint32_t y, int16_t z)
+{
+  if (mShowDates(nullptr, x, y, z)==kVIA_OK)
+  {
+    return kVIA_OK;   // call successful
+  }
+  return -1; // call failed
+}
+
+void CaplInstanceData::DllInfo(const char* x)
+{
+  mDllInfo(nullptr, V2XCaplString(x));
+}
+
+void CaplInstanceData::ArrayValues(uint32_t flags, uint32_t numberOfDatabytes, uint8_t databytes[], uint8_t controlcode)
+{
+  mArrayValues(nullptr, flags, V2XCaplArrayOf(databytes, numberOfDatabytes), controlcode);
+}
+
+void CaplInstanceData::OnBsm(uint32_t sequence)
+{
+  mOnBsm(nullptr, sequence);
+}
+
+bool CaplInstanceData::OpenTransport(const char* addr, uint16_t port)
+{
+  mTransport.SetBufferSize(mConfig.SendBufferSize);
+  mTransport.SetLinkHeader(mConfig.LinkHeader);
+  return mTransport.Open(addr, port);
+}
+
+void CaplInstanceData::CloseTransport()
+{
+  mTransport.Close();
+}
+
+int32_t CaplInstanceData::Send(const void* data, size_t length)
+{
+  int32_t sent;
+  if (mRing.IsOpen())
+  {
+    sent = mRing.Write(data, length) ? (int32_t)length : -1;
+  }
+  else
+  {
+    sent = mTransport.Send(data, length);
+  }
+  if (sent<0)
+  {
+    V2XStatAdd(kStatSendErrors, 1);
+    return sent;
+  }
+  V2XStatAdd(kStatDatagramsSent, 1);
+  V2XStatAdd(kStatBytesSent, sent);
+  V2XRecord(kRecordSent, data, length);
+  return sent;
+}
+
+int32_t CaplInstanceData::SendBatch(const V2XDatagram* datagrams, size_t count)
+{
+  if (mRing.IsOpen())
+  {
+    int32_t sent = 0;
+    for (size_t i=0; i<count; ++i)
+    {
+      if (Send(datagrams[i].data, datagrams[i].length)>=0)
+      {
+        ++sent;
+      }
+    }
+    return sent;
+  }
+
+  int32_t sent  = mTransport.SendBatch(datagrams, count);
+  size_t  bytes = 0;
+  for (int32_t i=0; i<sent; ++i)
+  {
+    bytes += datagrams[i].length;
+    V2XRecord(kRecordSent, datagrams[i].data, datagrams[i].length);
+  }
+  V2XStatAdd(kStatDatagramsSent, sent);
+  V2XStatAdd(kStatBytesSent, bytes);
+  V2XStatAdd(kStatSendErrors, count - sent);
+  return sent;
+}
+
+CaplInstanceData* GetCaplInstanceData(uint32_t handle)
+{
+  return gCaplTable.Find(handle);
+}
+
+// CAPL block selected by dllSelectInstance (or dllInit) in this thread
+static V2X_THREAD_LOCAL uint32_t sSelectedHandle = 0;
+static V2X_THREAD_LOCAL bool     sHasSelection   = false;
+
+// The V2X exports carry no CAPL handle, so they use the CAPL block selected
+// in the calling thread, else the only initialized CAPL block.
+//
+// All CAPL blocks run in the measurement thread, so the selection is the
+// one of the block that called dllSelectInstance or dllInit last. With
+// more than one CAPL block every event procedure that calls V2X functions
+// must start with dllSelectInstance(handle), see EXAMPLE/node/capldll.can.
+// With a single CAPL block dllInit selects it once and for all. Without a
+// valid selection and with several CAPL blocks there is no current block,
+// the V2X functions fail instead of working on an arbitrary one.
+CaplInstanceData* GetCurrentInstance()
+{
+  if (sHasSelection)
+  {
+    CaplInstanceData* inst = gCaplTable.Find(sSelectedHandle);
+    if (inst!=nullptr)
+    {
+      return inst;
+    }
+  }
+
+  CaplInstanceData* only = nullptr;
+  for (size_t i=0; i<VCaplTable::kSize; ++i)
+  {
+    CaplInstanceData* inst = gCaplTable.At(i, nullptr);
+    if (inst==nullptr)
+    {
+      continue;
+    }
+    if (only!=nullptr)
+    {
+      // reported once per thread, the measurement thread calls this per event
+      static V2X_THREAD_LOCAL bool sReported = false;
+      if (!sReported && gVIAService!=nullptr)
+      {
+        gVIAService->WriteString("V2X: several CAPL blocks use the DLL, call dllSelectInstance(handle) first in every event procedure");
+        sReported = true;
+      }
+      return nullptr;
+    }
+    only = inst;
+  }
+  return only;
+}
+
+
+// ============================================================================
+// V2XTimer
+// ============================================================================
+
+V2XTimer::V2XTimer(const char* name, Callback callback, void* context)
+ : mName(name),
+   mCallback(callback),
+   mContext(context),
+   mTimer(nullptr),
+   mPeriod(0)
+{}
+
+bool V2XTimer::Start(VIATime period)
+{
+  Stop();
+  if (gVIAService==nullptr)
+  {
+    return false;
+  }
+  if (gVIAService->CreateTimer(&mTimer, nullptr, this, mName)!=kVIA_OK)
+  {
+    mTimer = nullptr;
+    return false;
+  }
+  mPeriod = period;
+  mTimer->SetTimer(mPeriod);
+  return true;
+}
+
+// The timer must not be released inside its own OnTimer, a series ended by
+// the callback keeps it until Stop()
+void V2XTimer::Stop()
+{
+  if (mTimer==nullptr)
+  {
+    return;
+  }
+  mTimer->CancelTimer();
+  gVIAService->ReleaseTimer(mTimer);
+  mTimer = nullptr;
+}
+
+VIASTDDEF V2XTimer::OnTimer(VIATime nanoseconds)
+{
+  if (mCallback(mContext, nanoseconds) && mTimer!=nullptr)
+  {
+    mTimer->SetTimer(mPeriod);
+  }
+  return kVIA_OK;
+}
+
+
+// ============================================================================
+// V2XDispatcher
+// ============================================================================
+
+V2XDispatcher::V2XDispatcher(CaplInstanceData& owner)
+ : mOwner(owner),
+   mTimer("V2X OnBsm", &V2XDispatcher::sTick, this),
+   mSequence(0)
+{}
+
+void V2XDispatcher::Start()
+{
+  mSequence = gReceiver.Sequence();
+  if (!mTimer.IsRunning())
+  {
+    mTimer.Start(VIATimeMilliSec(kDispatchPeriodMs));
+  }
+}
+
+void V2XDispatcher::Stop()
+{
+  mTimer.Stop();
+}
+
+void V2XDispatcher::Dispatch()
+{
+  uint32_t sequence = gReceiver.Sequence();
+  if (sequence==mSequence)
+  {
+    return;
+  }
+  mSequence = sequence;
+  // the variables are current when CALLBACK_OnBsm runs
+  gSysVarMirror.Update(gReceiver);
+  mOwner.OnBsm(sequence);
+}
+
+bool V2XDispatcher::sTick(void* context, VIATime)
+{
+  ((V2XDispatcher*)context)->Dispatch();
+  return true;
+}
+
+
+// ============================================================================
+// V2XPublisher
+// ============================================================================
+
+V2XPublisher::V2XPublisher(CaplInstanceData& owner)
+ : mOwner(owner),
+   mTimer("V2X Publisher", &V2XPublisher::sTick, this)
+{}
+
+void V2XPublisher::Start(int32_t rateHz)
+{
+  Stop();
+  if (rateHz>0)
+  {
+    mTimer.Start(VIATimeMilliSec(1000) / rateHz);
+  }
+}
+
+void V2XPublisher::Stop()
+{
+  mTimer.Stop();
+}
+
+bool V2XPublisher::sTick(void* context, VIATime)
+{
+  V2XStatScope scope(kStatPublish);
+  ((V2XPublisher*)context)->mOwner.PublishAll();
+  return true;
+}
+
+
+// ============================================================================
+// V2XReplayer
+// ============================================================================
+
+V2XReplayer::V2XReplayer()
+ : mTimer("V2X Replay", &V2XReplayer::sTick, this),
+   mSpeed(1),
+   mLogStart(0),
+   mSimStart(-1),
+   mFinished(false)
+{}
+
+bool V2XReplayer::Start(const char* path, int32_t speed, uint32_t startMs)
+{
+  Stop();
+  if (gVIAService==nullptr || !mLog.Open(path))
+  {
+    return false;
+  }
+  mLogStart = (uint64_t)startMs * 1000000u;
+  mLog.Seek(mLogStart);
+  mSpeed    = (speed>0) ? speed : 0;
+  mSimStart = -1;
+  mFinished = false;
+  if (!mTimer.Start(VIATimeMilliSec(kDispatchPeriodMs)))
+  {
+    mLog.Close();
+    return false;
+  }
+  gReceiver.SetMuted(true);
+  return true;
+}
+
+void V2XReplayer::Stop()
+{
+  if (!mTimer.IsRunning())
+  {
+    return;
+  }
+  mTimer.Stop();
+  Finish();
+}
+
+// End of the log or Stop()
+void V2XReplayer::Finish()
+{
+  mLog.Close();
+  mFinished = true;
+  gReceiver.SetMuted(false);
+}
+
+bool V2XReplayer::sTick(void* context, VIATime now)
+{
+  return ((V2XReplayer*)context)->Tick(now);
+}
+
+bool V2XReplayer::Tick(VIATime now)
+{
+  if (mFinished)
+  {
+    return false;
+  }
+  if (mSimStart<0)
+  {
+    mSimStart = now;
+  }
+
+  V2XRecordEntry entry;
+  if (mSpeed==0)
+  {
+    bool found = false;
+    while (!found && mLog.Next(entry))
+    {
+      found = entry.direction==kRecordReceived;
+    }
+    if (found)
+    {
+      gReceiver.Inject(entry.data, (int32_t)entry.length);
+    }
+  }
+  else
+  {
+    uint64_t due = mLogStart + (uint64_t)(now - mSimStart) * (uint64_t)mSpeed;
+    while (mLog.Peek(entry) && entry.time<=due)
+    {
+      mLog.Next(entry);
+      if (entry.direction==kRecordReceived)
+      {
+        gReceiver.Inject(entry.data, (int32_t)entry.length);
+      }
+    }
+  }
+
+  V2XRecordEntry next;
+  if (!mLog.Peek(next))
+  {
+    Finish();
+    return false;
+  }
+  return true;
+}
+
+
+
+
+// ============================================================================
+// V2XPoller
+// ============================================================================
+
+V2XPoller::V2XPoller()
+ : mTimer("V2X Receive", &V2XPoller::sTick, this)
+{}
+
+void V2XPoller::Start()
+{
+  if (!mTimer.IsRunning())
+  {
+    mTimer.Start(VIATimeMilliSec(kDispatchPeriodMs));
+  }
+}
+
+void V2XPoller::Stop()
+{
+  mTimer.Stop();
+}
+
+bool V2XPoller::sTick(void*, VIATime)
+{
+  if (gReceiver.Poll(kPollDatagramsPerTick)>0)
+  {
+    for (size_t i=0; i<VCaplTable::kSize; ++i)
+    {
+      CaplInstanceData* inst = gCaplTable.At(i, nullptr);
+      if (inst!=nullptr)
+      {
+        inst->DispatchBsm();
+      }
+    }
+  }
+  return true;
+}
+
+
+// ============================================================================
+// CaplInstanceData, V2X send side
+// ============================================================================
+
+// Serializes the next message of 'vehicle' into 'buffer' in 'format', returns
+// its length or 0 if the vehicle has nothing to send. A delta without
+// changed fields is skipped, it still counts towards the next keyframe so
+// an unchanged vehicle is repeated at the keyframe interval.
+static size_t sEncodeVehicle(const V2XSendConfig& config, int format, V2XVehicle& vehicle, char* buffer, size_t size)
+{
+  if (vehicle.setFields==0)
+  {
+    return 0;
+  }
+  bool       keyframe = config.KeyframeInterval<=0 || (vehicle.sendSlot % config.KeyframeInterval)==0;
+  V2XBsmMask fields   = keyframe ? vehicle.setFields : (vehicle.setFields & vehicle.dirtyFields);
+  ++vehicle.sendSlot;
+  if (fields==0)
+  {
+    return 0;
+  }
+
+  size_t length;
+  if (format==kWireBinary)
+  {
+    V2XBsmFrame frame;
+    V2XFrameFromBsm(vehicle.bsm, fields, frame);
+    frame.seq   = vehicle.sendSeq;
+    frame.flags = keyframe ? kBsmFrameKeyframe : 0;
+    length = V2XEncodeFrame(frame, buffer, size);
+  }
+  else
+  {
+    V2XJsonWriter writer(buffer, size);
+    writer.BeginObject();
+    V2XWriteBsm(writer, vehicle.bsm, fields);
+    if (config.KeyframeInterval>0)
+    {
+      writer.Key(kBsmSeqKey);
+      writer.Int(vehicle.sendSeq);
+      writer.Key(kBsmKeyframeKey);
+      writer.Int(keyframe ? 1 : 0);
+    }
+    writer.EndObject();
+    length = writer.Length();
+  }
+  vehicle.dirtyFields = 0;
+  ++vehicle.sendSeq;
+  return length;
+}
+
+void CaplInstanceData::StartV2X()
+{
+  mDispatcher.Start();
+  mPublisher.Start(mConfig.PublishRateHz);
+}
+
+void CaplInstanceData::StopV2X()
+{
+  mPublisher.Stop();
+  mDispatcher.Stop();
+}
+
+void CaplInstanceData::SetPublishRate(int32_t rateHz)
+{
+  mConfig.PublishRateHz = rateHz;
+  mPublisher.Start(rateHz);
+}
+
+int32_t CaplInstanceData::SetDestinations(const char* destinations)
+{
+  if (destinations==nullptr || destinations[0]==0)
+  {
+    destinations = addr;
+  }
+  return mTransport.SetDestinations(destinations, (uint16_t)Port);
+}
+
+bool CaplInstanceData::SetMulticast(int32_t ttl, bool loopback, const char* interfaceAddr)
+{
+  return mTransport.SetMulticast(ttl, loopback, interfaceAddr);
+}
+
+bool CaplInstanceData::OpenRing(const char* name, uint32_t slots)
+{
+  if (name==nullptr || name[0]==0)
+  {
+    mRing.Close();
+    return true;
+  }
+  // a slot holds one binary frame, see WireFormat; the configured format
+  // stays untouched and applies again when the ring is closed
+  return mRing.Open(name, slots);
+}
+
+void CaplInstanceData::SetLinkHeader(bool enable)
+{
+  mConfig.LinkHeader = enable;
+  mTransport.SetLinkHeader(enable);
+}
+
+void CaplInstanceData::SetSendBufferSize(int32_t bytes)
+{
+  mConfig.SendBufferSize = bytes;
+  mTransport.SetBufferSize(bytes);
+}
+
+void CaplInstanceData::SelectVehicle(const char* id)
+{
+  if (mConfig.MultiVehicle)
+  {
+    mVehicles.Select(id);
+  }
+}
+
+void CaplInstanceData::ResetVehicles()
+{
+  mVehicles.Reset();
+}
+
+void CaplInstanceData::BsmChanged(V2XBsmMask fields, bool isEvent)
+{
+  V2XVehicle& vehicle = mVehicles.Current();
+  vehicle.dirtyFields |= fields;
+  vehicle.setFields   |= fields;
+  if (!mPublisher.IsRunning() || (isEvent && mConfig.PublishEventsImmediately))
+  {
+    PublishCurrent();
+  }
+}
+
+void CaplInstanceData::PublishCurrent()
+{
+  char   buffer[kBsmJsonMaxSize];
+  size_t length = sEncodeVehicle(mConfig, WireFormat(), mVehicles.Current(), buffer, sizeof(buffer));
+  if (length>0)
+  {
+    Send(buffer, length);
+  }
+}
+
+void CaplInstanceData::PublishAll()
+{
+  V2XDatagram datagrams[V2XTransport::kMaxBatch];
+  size_t      count = 0;
+  for (V2XVehicleTable::Map::iterator lIter=mVehicles.Begin(); lIter!=mVehicles.End(); ++lIter)
+  {
+    size_t length = sEncodeVehicle(mConfig, WireFormat(), lIter->second, mBatchBuffer[count], kBsmJsonMaxSize);
+    if (length==0)
+    {
+      continue;
+    }
+    datagrams[count].data   = mBatchBuffer[count];
+    datagrams[count].length = length;
+    if (++count==V2XTransport::kMaxBatch)
+    {
+      SendBatch(datagrams, count);
+      count = 0;
+    }
+  }
+  if (count>0)
+  {
+    SendBatch(datagrams, count);
+  }
+}
+
+void CaplInstanceData::DispatchBsm()
+{
+  mDispatcher.Dispatch();
+}
+
+
+// ============================================================================
+// CaplInstanceData
+//
+// Data local for a single CAPL Block.
+//
+// A CAPL-DLL can be used by more than one CAPL-Block, so every piece of
+// information thats like a global variable in CAPL, must now be wrapped into
+// an instance of an object.
+// ============================================================================
+
+void CAPLEXPORT CAPLPASCAL appInit (uint32_t handle)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  CaplInstanceData* instance = GetCaplInstanceData(handle);
+  if ( nullptr==instance )
+  {
+    VIACapl* service = gServiceTable.Find(handle);
+    if ( nullptr!=service )
+    {
+      try
+      {
+        instance = new CaplInstanceData(service);
+      }
+      catch ( std::bad_alloc& )
+      {
+        return; // proceed without change
+      }
+      instance->GetCallbackFunctions();
+      if (!gCaplTable.Insert(handle, instance))
+      {
+        instance->ReleaseCallbackFunctions();
+        delete instance;
+        return; // too many CAPL blocks
+      }
+      instance->OpenTransport(addr, (uint16_t)Port);
+
+      // the first CAPL block starts the receiver
+      if (!gReceiver.IsRunning() && gReceiver.Start((uint16_t)RecvPort, gReceiveMode==kReceiveTimer) && gReceiver.IsPolled())
+      {
+        gPoller.Start();
+      }
+      instance->StartV2X();
+    }
+  }
+
+  // the V2X functions called from this thread now work on this CAPL block
+  if ( nullptr!=instance )
+  {
+    sSelectedHandle = handle;
+    sHasSelection   = true;
+  }
+}
+
+void CAPLEXPORT CAPLPASCAL appEnd (uint32_t handle)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  CaplInstanceData* inst = gCaplTable.Remove(handle);
+  if (inst==nullptr)
+  {
+    return;
+  }
+  inst->StopV2X();
+  inst->ReleaseCallbackFunctions();
+  inst->CloseTransport();
+
+  delete inst;
+  inst = nullptr;
+
+  // the last CAPL block stops the receiver thread, the replay, the
+  // system variable mirror, the capture and the stats dump
+  if (gCaplTable.First()==nullptr)
+  {
+    gReplayer.Stop();
+    gSysVarMirror.Close();
+    gPoller.Stop();
+    gReceiver.Stop();
+    V2XStopCapture();
+    V2XStopStatsDump();
+  }
+}
+
+int32_t CAPLEXPORT CAPLPASCAL appSetValue (uint32_t handle, int32_t x)
+{
+  CaplInstanceData* inst = GetCaplInstanceData(handle);
+  if (inst==nullptr)
+  {
+    return -1;
+  }
+
+  return inst->ShowValue(x);
+}
+
+int32_t CAPLEXPORT CAPLPASCAL appReadData (uint32_t handle, int32_t a)
+{
+  CaplInstanceData* inst = GetCaplInstanceData(handle);
+  if (inst==nullptr)
+  {
+    return -1;
+  }
+
+  int16_t  x = (a>=0) ? +1 : -1;
+  uint32_t y = abs(a);
+  int16_t  z = (int16)(a & 0x0f000000) >> 24;
 
-  // Definition of the class function.
-  // This class function will call the CAPL callback functions
-  uint32_t ShowValue(uint32_t x);
-  uint32_t ShowDates(int16_t x, uint32_t y, int16_t z);
-  void     DllInfo(const char* x);
-  void     ArrayValues(uint32_t flags, uint32_t numberOfDatabytes, uint8_t databytes[], uint8_t controlcode);
-  void     DllVersion(const char* y);
+  inst->DllVersion("Version 1.1");
 
-private:
+  inst->DllInfo("DLL: processing");
 
-  // Pointer of the CAPL callback functions
-  VIACaplFunction*  mShowValue;
-  VIACaplFunction*  mShowDates;
-  VIACaplFunction*  mDllInfo;
-  VIACaplFunction*  mArrayValues;
-  VIACaplFunction*  mDllVersion;
+  uint8_t databytes[8] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
 
-  VIACapl*          mCapl;
-};
+  inst->ArrayValues( 0xaabbccdd, sizeof(databytes), databytes, 0x01);
 
+  return inst->ShowDates( x, y, z);
+}
 
-CaplInstanceData::CaplInstanceData(VIACapl* capl)
-  // This function will initialize the CAPL callback function
-  // with the NLL Pointer
- : mCapl(capl),
-   mShowValue(nullptr),
-   mShowDates(nullptr),
-   mDllInfo(nullptr),
-   mArrayValues(nullptr),
-   mDllVersion(nullptr)
-{}
 
-static bool sCheckParams(VIACaplFunction* f, char rtype, const char* ptype)
+void CAPLEXPORT CAPLPASCAL appSelectInstance (uint32_t handle)
 {
-  char      type;
-  int32_t   pcount;
-  VIAResult rc;
-
-  // check return type
-  rc = f->ResultType(&type);
-  if (rc!=kVIA_OK || type!=rtype)
-  {
-    return false;
-  }
-
-  // check number of parameters
-  rc = f->ParamCount(&pcount);
-  if (rc!=kVIA_OK || strlen(ptype)!=pcount )
-  {
-    return false;
-  }
+  sSelectedHandle = handle;
+  sHasSelection   = true;
+}
 
-  // check type of parameters
-  for (int32_t i=0; i<pcount; ++i)
+void CAPLEXPORT CAPLPASCAL appDispatchBsm (void)
+{
+  V2XStatScope scope(kStatDispatchBsm);
+  gReceiver.Poll(kPollDatagramsPerTick);
+  for (size_t i=0; i<VCaplTable::kSize; ++i)
   {
-    rc = f->ParamType(&type, i);
-    if (rc!=kVIA_OK || type!=ptype[i])
+    CaplInstanceData* inst = gCaplTable.At(i, nullptr);
+    if (inst!=nullptr)
     {
-      return false;
+      inst->DispatchBsm();
     }
   }
-
-  return true;
 }
 
-static VIACaplFunction* sGetCaplFunc(VIACapl* capl, const char* fname, char rtype, const char* ptype)
+// The options below apply to the current CAPL block and to the CAPL blocks
+// initialized later. gDefaultConfig is only accessed under gInitMutex.
+void CAPLEXPORT CAPLPASCAL appSetPublishRate (int32_t rateHz)
 {
-  VIACaplFunction* f;
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-  // get capl function object
-  VIAResult rc =  capl->GetCaplFunction(&f, fname);
-  if (rc!=kVIA_OK || f==nullptr)
+  gDefaultConfig.PublishRateHz = (rateHz>0) ? rateHz : 0;
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst!=nullptr)
   {
-    return nullptr;
+    inst->SetPublishRate(gDefaultConfig.PublishRateHz);
   }
+}
 
-  // check signature of function
-  if ( sCheckParams(f, rtype, ptype) )
-  {
-     return f;
-  }
-  else
+void CAPLEXPORT CAPLPASCAL appSetImmediateEvents (int32_t enable)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  gDefaultConfig.PublishEventsImmediately = (enable!=0);
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst!=nullptr)
   {
-    capl->ReleaseCaplFunction(f);
-    return nullptr;
+    inst->Config().PublishEventsImmediately = gDefaultConfig.PublishEventsImmediately;
   }
 }
 
-void CaplInstanceData::GetCallbackFunctions()
+void CAPLEXPORT CAPLPASCAL appSetDeltaMode (int32_t keyframeInterval)
 {
-  // Get a CAPL function handle. The handle stays valid until end of
-  // measurement or a call of ReleaseCaplFunction.
-  mShowValue   = sGetCaplFunc(mCapl, "CALLBACK_ShowValue", 'D', "D");
-  mShowDates   = sGetCaplFunc(mCapl, "CALLBACK_ShowDates", 'D', "IDI");
-  mDllInfo     = sGetCaplFunc(mCapl, "CALLBACK_DllInfo", 'V', "C");
-  mArrayValues = sGetCaplFunc(mCapl, "CALLBACK_ArrayValues", 'V', "DBB");
-  mDllVersion  = sGetCaplFunc(mCapl, "CALLBACK_DllVersion", 'V', "C");
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  gDefaultConfig.KeyframeInterval = (keyframeInterval>0) ? keyframeInterval : 0;
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst!=nullptr)
+  {
+    inst->Config().KeyframeInterval = gDefaultConfig.KeyframeInterval;
+  }
 }
 
-void CaplInstanceData::ReleaseCallbackFunctions()
+void CAPLEXPORT CAPLPASCAL appSetWireFormat (int32_t format)
 {
-  // Release all the requested Callback functions
-  mCapl->ReleaseCaplFunction(mShowValue);
-  mShowValue = nullptr;
-  mCapl->ReleaseCaplFunction(mShowDates);
-  mShowDates = nullptr;
-  mCapl->ReleaseCaplFunction(mDllInfo);
-  mDllInfo = nullptr;
-  mCapl->ReleaseCaplFunction(mArrayValues);
-  mArrayValues = nullptr;
-  mCapl->ReleaseCaplFunction(mDllVersion);
-  mDllVersion = nullptr;
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  gDefaultConfig.WireFormat = (format==kWireBinary) ? kWireBinary : kWireJson;
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst!=nullptr)
+  {
+    inst->Config().WireFormat = gDefaultConfig.WireFormat;
+  }
 }
 
-void CaplInstanceData::DllVersion(const char* y)
+void CAPLEXPORT CAPLPASCAL appSetMultiVehicle (int32_t enable)
 {
-  // Prepare the parameters for the call stack of CAPL.
-  // Arrays uses a 8 byte (64 bit DLL: 12 byte) on the stack, 4 Bytes for the number of element,
-  // and 4 bytes (64 bit DLL: 8 byte) for the pointer to the array
-  int32_t sizeX = (int32_t)strlen(y)+1;
-
-#if defined(X64)
-  uint8_t params[16];              // parameters for call stack, 16 Bytes total (8 bytes per parameter, reverse order of parameters)
-  memcpy(params+8, &sizeX, 4);   // array size    of first parameter, 4 Bytes
-  memcpy(params+0, &y,     8);   // array pointer of first parameter, 8 Bytes
-#else
-  uint8_t params[8];               // parameters for call stack, 8 Bytes total
-  memcpy(params+0, &sizeX, 4);   // array size    of first parameter, 4 Bytes
-  memcpy(params+4, &y,     4);   // array pointer of first parameter, 4 Bytes
-#endif
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-  if(mDllVersion!=nullptr)
+  gDefaultConfig.MultiVehicle = (enable!=0);
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst!=nullptr)
   {
-    uint32_t result; // dummy variable
-    VIAResult rc =  mDllVersion->Call(&result, params);
+    inst->Config().MultiVehicle = gDefaultConfig.MultiVehicle;
+    if (!gDefaultConfig.MultiVehicle)
+    {
+      inst->ResetVehicles();
+    }
   }
 }
 
-
-uint32_t CaplInstanceData::ShowValue(uint32_t x)
+// Socket buffer sizes in bytes, 0 keeps the current size. The receive
+// buffer belongs to the receiver shared by all CAPL blocks.
+void CAPLEXPORT CAPLPASCAL appSetSocketBuffers (int32_t receiveBytes, int32_t sendBytes)
 {
-#if defined(X64)
-  uint8_t params[8];               // parameters for call stack, 8 Bytes total
-  memcpy(params + 0, &x, 8);     // first parameter, 8 Bytes
-#else
-  void* params = &x;   // parameters for call stack
-#endif
-
-  uint32_t result;
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-  if(mShowValue!=nullptr)
+  if (receiveBytes>0)
+  {
+    gReceiver.SetBufferSize(receiveBytes);
+  }
+  if (sendBytes>0)
   {
-    VIAResult rc =  mShowValue->Call(&result, params);
-    if (rc==kVIA_OK)
+    gDefaultConfig.SendBufferSize = sendBytes;
+    CaplInstanceData* inst = GetCurrentInstance();
+    if (inst!=nullptr)
     {
-       return result;
+      inst->SetSendBufferSize(sendBytes);
     }
   }
-  return -1;
 }
 
-uint32_t CaplInstanceData::ShowDates(int16_t x, uint32_t y, int16_t z)
+// Receives in a thread (kReceiveThread) or in the measurement context
+// (kReceiveTimer, see V2XPoller). A running receiver restarts in the new
+// mode. Returns 0 or -1 for an unknown mode or if the receiver cannot
+// restart.
+int32_t CAPLEXPORT CAPLPASCAL appSetReceiveMode (int32_t mode)
 {
-  // Prepare the parameters for the call stack of CAPL. The stack grows
-  // from top to down, so the first parameter in the parameter list is the last
-  // one in memory. CAPL uses also a 32 bit alignment for the parameters.
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-#if defined(X64)
-  uint8_t params[24];          // parameters for call stack, 24 Bytes total (8 bytes per parameter, reverse order of parameters)
-  memcpy(params+16, &z, 2);  // third  parameter, offset 16, 2 Bytes
-  memcpy(params+ 8, &y, 4);  // second parameter, offset 8,  4 Bytes
-  memcpy(params+ 0, &x, 2);  // first  parameter, offset 0,  2 Bytes
-#else
-  uint8_t params[12];         // parameters for call stack, 12 Bytes total
-  memcpy(params+0, &z, 2);  // third  parameter, offset 0, 2 Bytes
-  memcpy(params+4, &y, 4);  // second parameter, offset 4, 4 Bytes
-  memcpy(params+8, &x, 2);  // first  parameter, offset 8, 2 Bytes
-#endif
+  if (mode!=kReceiveThread && mode!=kReceiveTimer)
+  {
+    return -1;
+  }
+  gReceiveMode = mode;
+  if (!gReceiver.IsRunning() || gReceiver.IsPolled()==(mode==kReceiveTimer))
+  {
+    return 0;
+  }
+  gPoller.Stop();
+  gReceiver.Stop();
+  if (!gReceiver.Start((uint16_t)RecvPort, mode==kReceiveTimer))
+  {
+    return -1;
+  }
+  if (mode==kReceiveTimer)
+  {
+    gPoller.Start();
+  }
+  return 0;
+}
 
-  uint32_t result;
+// Puts the link header of v2x_link.h in front of every sent datagram. Off
+// by default, only receivers that strip it (receive_upd_signal.py,
+// v2x_ros_receive) may get it.
+void CAPLEXPORT CAPLPASCAL appSetLinkHeader (int32_t enable)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-  if(mShowDates!=nullptr)
+  gDefaultConfig.LinkHeader = (enable!=0);
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst!=nullptr)
   {
-    VIAResult rc =  mShowDates->Call(&result, params);
-    if (rc==kVIA_OK)
-    {
-       return rc;   // call successful
-    }
+    inst->SetLinkHeader(gDefaultConfig.LinkHeader);
   }
+}
 
-  return -1; // call failed
+// Age in ms after which the Get*Ex functions report a value as stale
+void CAPLEXPORT CAPLPASCAL appSetStaleAge (int32_t ageMs)
+{
+  if (ageMs>0)
+  {
+    gStaleAgeMs.store(ageMs);
+  }
 }
 
-void CaplInstanceData::DllInfo(const char* x)
+// Maps bus signals onto the BSM fields of the current CAPL block by the
+// V2XField and V2XFactor attributes of the DBC 'path', see
+// v2x_signal_map.h. An empty path removes the mapping. Returns the number
+// of mapped signals or -1 if the DBC cannot be read.
+int32_t CAPLEXPORT CAPLPASCAL appLoadSignalMap (const char* path)
 {
-  // Prepare the parameters for the call stack of CAPL.
-  // Arrays uses a 8 byte (64 bit DLL: 12 byte) on the stack, 4 Bytes for the number of element,
-  // and 4 bytes (64 bit DLL: 8 byte) for the pointer to the array
-  int32_t sizeX = (int32)strlen(x)+1;
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-#if defined(X64)
-  uint8_t params[16];              // parameters for call stack, 16 Bytes total (8 bytes per parameter, reverse order of parameters)
-  memcpy(params+8, &sizeX, 4);   // array size    of first parameter, 4 Bytes
-  memcpy(params+0, &x,     8);   // array pointer of first parameter, 8 Bytes
-#else
-  uint8_t params[8];               // parameters for call stack, 8 Bytes total
-  memcpy(params+0, &sizeX, 4);   // array size    of first parameter, 4 Bytes
-  memcpy(params+4, &x,     4);   // array pointer of first parameter, 4 Bytes
-#endif
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst==nullptr)
+  {
+    return -1;
+  }
+  if (path==nullptr || path[0]==0)
+  {
+    inst->SignalMap().Clear();
+    return 0;
+  }
 
-  if(mDllInfo!=nullptr)
+  std::string error;
+  int32_t     count = inst->SignalMap().Load(path, error);
+  if (!error.empty() && gVIAService!=nullptr)
   {
-    uint32_t result; // dummy variable
-    VIAResult rc =  mDllInfo->Call(&result, params);
+    gVIAService->WriteString(("V2X signal map: " + error).c_str());
   }
+  return count;
 }
 
-void CaplInstanceData::ArrayValues(uint32_t flags, uint32_t numberOfDatabytes, uint8_t databytes[], uint8_t controlcode)
+// Decodes the mapped signals of a bus frame into the BSM of the current
+// vehicle, one call per frame from "on message *" (see v2x_signal_map.h
+// why CAPL forwards the frames). Returns the number of fields written, 0
+// for frames without mapped signals.
+int32_t CAPLEXPORT CAPLPASCAL appOnBusMessage (uint32_t id, int32_t length, const uint8_t data[])
 {
-  // Prepare the parameters for the call stack of CAPL. The stack grows
-  // from top to down, so the first parameter in the parameter list is the last
-  // one in memory. CAPL uses also a 32 bit alignment for the parameters.
-  // Arrays uses a 8 byte (64 bit DLL: 12 byte) on the stack, 4 Bytes for the number of element,
-  // and 4 bytes (64 bit DLL: 8 byte) for the pointer to the array
-
-#if defined(X64)
-  uint8_t params[32];                           // parameters for call stack, 32 Bytes total (8 bytes per parameter, reverse order of parameters)
-  memcpy(params+24, &controlcode,       1);   // third parameter,                  offset 24, 1 Bytes
-  memcpy(params+16, &numberOfDatabytes, 4);   // second parameter (array size),    offset 16, 4 Bytes
-  memcpy(params+ 8, &databytes,         8);   // second parameter (array pointer), offset  8, 8 Bytes
-  memcpy(params+ 0, &flags,             4);   // first  parameter,                 offset  0, 4 Bytes
-#else
-  uint8_t params[16];                           // parameters for call stack, 16 Bytes total
-  memcpy(params+ 0, &controlcode,       1);   // third parameter,                  offset  0, 1 Bytes
-  memcpy(params+ 4, &numberOfDatabytes, 4);   // second parameter (array size),    offset  4, 4 Bytes
-  memcpy(params+ 8, &databytes,         4);   // second parameter (array pointer), offset  8, 4 Bytes
-  memcpy(params+12, &flags,             4);   // first  parameter,                 offset 12, 4 Bytes
-#endif
+  V2XStatScope scope(kStatOnBusMessage);
+  std::lock_guard<std::mutex> lock(gInitMutex);
 
-  if(mArrayValues!=nullptr)
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst==nullptr || length<=0)
   {
-    uint32_t result; // dummy variable
-    VIAResult rc =  mArrayValues ->Call(&result, params);
+    return 0;
   }
 
+  V2XBsmMask fields = inst->SignalMap().Decode(id, data, (size_t)length, inst->Vehicles().Current().bsm);
+  if (fields==0)
+  {
+    return 0;
+  }
+  int32_t count   = 0;
+  bool    isEvent = false;
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    if ((fields & V2XBsmBit((V2XBsmField)i))!=0)
+    {
+      ++count;
+      isEvent = isEvent || kBsmFields[i].event;
+    }
+  }
+  inst->BsmChanged(fields, isEvent);
+  return count;
 }
 
-CaplInstanceData* GetCaplInstanceData(uint32_t handle)
+// Mirrors the received fields into integer system variables of the
+// namespace 'path' (e.g. "V2X::RemoteBsm"), written when a field changes.
+// An empty path stops the mirror. Returns 0 or -1 without system variables
+// (no VIA service).
+int32_t CAPLEXPORT CAPLPASCAL appSetSysVarNamespace (const char* path)
 {
-  VCaplMap::iterator lSearchResult(gCaplMap.find(handle));
-  if ( gCaplMap.end()==lSearchResult )
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  if (path==nullptr || path[0]==0)
   {
-    return nullptr;
-  } 
-  else 
+    gSysVarMirror.Close();
+    return 0;
+  }
+  if (!gSysVarMirror.Open(gVIAService, path))
   {
-    return lSearchResult->second;
+    return -1;
   }
+  gSysVarMirror.Update(gReceiver);
+  return 0;
 }
 
-// ============================================================================
-// CaplInstanceData
-//
-// Data local for a single CAPL Block.
-//
-// A CAPL-DLL can be used by more than one CAPL-Block, so every piece of
-// information thats like a global variable in CAPL, must now be wrapped into
-// an instance of an object.
-// ============================================================================
-
-void CAPLEXPORT CAPLPASCAL appInit (uint32_t handle)
+// Sends the BSMs of the current CAPL block through the shared memory ring
+// 'name' (see v2x_shm.h) in the binary wire format, an empty name goes
+// back to UDP in the format of dllSetWireFormat. Returns 0 or -1 if the
+// ring cannot be mapped.
+int32_t CAPLEXPORT CAPLPASCAL appSetSharedMemory (const char* name, int32_t slots)
 {
-  CaplInstanceData* instance = GetCaplInstanceData(handle);
-  if ( nullptr==instance )
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst==nullptr)
   {
-    VServiceMap::iterator lSearchService(gServiceMap.find(handle));
-    if ( gServiceMap.end()!=lSearchService )
-    {
-      VIACapl* service = lSearchService->second;
-      try
-      {
-        instance = new CaplInstanceData(service);
-      }
-      catch ( std::bad_alloc& )
-      {
-        return; // proceed without change
-      }
-      instance->GetCallbackFunctions();
-      gCaplMap[handle] = instance;
-    }
+    return -1;
   }
+  return inst->OpenRing(name, (slots>0) ? (uint32_t)slots : 0) ? 0 : -1;
 }
 
-void CAPLEXPORT CAPLPASCAL appEnd (uint32_t handle)
+// Sends the BSMs of the current CAPL block to every entry of
+// 'destinations', "addr[:port]" separated by ',' or ';', each datagram is
+// serialized once. A multicast group like "239.255.0.1:20000" is a single
+// entry. An empty list goes back to addr:Port. Returns the number of
+// destinations or -1 if an entry is invalid.
+int32_t CAPLEXPORT CAPLPASCAL appSetDestinations (const char* destinations)
 {
-  CaplInstanceData* inst = GetCaplInstanceData(handle);
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  CaplInstanceData* inst = GetCurrentInstance();
   if (inst==nullptr)
   {
-    return;
+    return -1;
   }
-  inst->ReleaseCallbackFunctions();
-
-  delete inst;
-  inst = nullptr;
-  gCaplMap.erase(handle);
+  return inst->SetDestinations(destinations);
 }
 
-int32_t CAPLEXPORT CAPLPASCAL appSetValue (uint32_t handle, int32_t x)
+// TTL and loopback of multicast datagrams of the current CAPL block,
+// 'interfaceAddr' is the address of the outgoing interface, empty keeps
+// the choice of the system. Returns 0 or -1 if the address is invalid.
+int32_t CAPLEXPORT CAPLPASCAL appSetMulticast (int32_t ttl, int32_t loopback, const char* interfaceAddr)
 {
-  CaplInstanceData* inst = GetCaplInstanceData(handle);
+  std::lock_guard<std::mutex> lock(gInitMutex);
+
+  CaplInstanceData* inst = GetCurrentInstance();
   if (inst==nullptr)
   {
     return -1;
   }
+  return inst->SetMulticast(ttl, loopback!=0, interfaceAddr) ? 0 : -1;
+}
 
-  return inst->ShowValue(x);
+
+// ============================================================================
+// Statistics, see v2x_stats.h
+// ============================================================================
+
+// Fills 'values' with calls, min, mean, p50, p90, p99 and max latency in ns
+// of the CAPL function 'name', returns the number of values or -1 if the
+// function is not instrumented
+int32_t CAPLEXPORT CAPLPASCAL appGetStats (const char* name, uint32_t values[], int32_t count)
+{
+  int32_t id = V2XStatFind(name);
+  if (id<0 || values==nullptr)
+  {
+    return -1;
+  }
+  return V2XGetExportStats((V2XStatExport)id, values, count);
 }
 
-int32_t CAPLEXPORT CAPLPASCAL appReadData (uint32_t handle, int32_t a)
+// Fills 'values' with the V2XStatCounter counters, returns their number
+int32_t CAPLEXPORT CAPLPASCAL appGetCounters (uint32_t values[], int32_t count)
 {
-  CaplInstanceData* inst = GetCaplInstanceData(handle);
-  if (inst==nullptr)
+  if (values==nullptr)
   {
     return -1;
   }
+  int32_t written = 0;
+  for (; written<count && written<kStatCounterCount; ++written)
+  {
+    uint64_t value = V2XStatCounterValue((V2XStatCounter)written);
+    values[written] = (value>0xffffffffu) ? 0xffffffffu : (uint32_t)value;
+  }
+  return written;
+}
 
-  int16_t  x = (a>=0) ? +1 : -1;
-  uint32_t y = abs(a);
-  int16_t  z = (int16)(a & 0x0f000000) >> 24;
+void CAPLEXPORT CAPLPASCAL appResetStats (void)
+{
+  V2XResetStats();
+}
 
-  inst->DllVersion("Version 1.1");
+int32_t CAPLEXPORT CAPLPASCAL appSetStatsDump (const char* path, int32_t periodMs)
+{
+  return V2XStartStatsDump(path, (periodMs>0) ? (uint32_t)periodMs : 0) ? 0 : -1;
+}
 
-  inst->DllInfo("DLL: processing");
 
-  uint8_t databytes[8] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+// ============================================================================
+// Capture and replay, see v2x_record.h
+// ============================================================================
 
-  inst->ArrayValues( 0xaabbccdd, sizeof(databytes), databytes, 0x01);
+// Writes every datagram sent and received from now on to the log 'path',
+// returns 0 or -1 if the file cannot be created
+int32_t CAPLEXPORT CAPLPASCAL appStartCapture (const char* path)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+  return V2XStartCapture(path) ? 0 : -1;
+}
 
-  return inst->ShowDates( x, y, z);
+void CAPLEXPORT CAPLPASCAL appStopCapture (void)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+  V2XStopCapture();
+}
+
+// Replays the received datagrams of the log 'path' from 'startMs' on at
+// 'speed' times the recorded rate, 0 as fast as possible. Returns 0 or -1
+// if the log cannot be read or the VIA service is missing.
+int32_t CAPLEXPORT CAPLPASCAL appStartReplay (const char* path, int32_t speed, int32_t startMs)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+  return gReplayer.Start(path, speed, (startMs>0) ? (uint32_t)startMs : 0) ? 0 : -1;
+}
+
+void CAPLEXPORT CAPLPASCAL appStopReplay (void)
+{
+  std::lock_guard<std::mutex> lock(gInitMutex);
+  gReplayer.Stop();
+}
+
+// 1 while a replay runs, 0 after the end of the log
+int32_t CAPLEXPORT CAPLPASCAL appIsReplaying (void)
+{
+  return gReplayer.IsRunning() ? 1 : 0;
 }
 
 
@@ -444,26 +1546,43 @@ VIACLIENT(void) VIARegisterCDLL (VIACapl* service)
   }
 
   // appInit (internal) resp. "DllInit" (CAPL code) has to follow
-  gServiceMap[handle] = service;
+  gServiceTable.Insert(handle, service);
+}
+
+// ============================================================================
+// VIA setup functions
+//
+// The VIA service gives the DLL access to timers, which run in the
+// measurement context like the CAPL program itself.
+// ============================================================================
+
+VIACLIENT(void) VIARequiredVersion (int32* majorversion, int32* minorversion)
+{
+  *majorversion = VIAMajorVersion;
+  *minorversion = VIAMinorVersion;
+}
+
+VIACLIENT(void) VIASetService (VIAService* service)
+{
+  gVIAService = service;
 }
 
 void ClearAll()
 {
   // destroy objects created by this DLL
   // may result from forgotten DllEnd calls
-  VCaplMap::iterator lIter=gCaplMap.begin();
-  const int32_t cNumberOfEntries = (int32_t)gCaplMap.size();
-  int32_t i = 0;
-  while ( lIter!=gCaplMap.end() && i<cNumberOfEntries )
+  uint32_t handle;
+  for (size_t i=0; i<VCaplTable::kSize; ++i)
   {
-    appEnd( (*lIter).first );
-    lIter = gCaplMap.begin(); // first element should have vanished
-    i++; // assure that no more erase trials take place than the original size of the map
+    if (gCaplTable.At(i, &handle)!=nullptr)
+    {
+      appEnd(handle);
+    }
   }
 
   // just for clarity (would be done automatically)
-  gCaplMap.clear();
-  gServiceMap.clear();
+  gCaplTable.Clear();
+  gServiceTable.Clear();
 }
 
 /*
@@ -580,1076 +1699,171 @@ void CAPLEXPORT CAPLPASCAL appPutDataOnePar(const uint8_t dataBlock[] )
 }
 */
 
-//add new function
-Json::Value root;
-Json::StyledWriter style_writer;
-Json::Reader reader;
-WSADATA wsaData;
+// Store a value into field F of 'bsm', the offset of the field is a
+// constant of the instantiation
+template <V2XBsmField F>
+static void sStoreInt(V2XBsm& bsm, int32_t value)
+{
+  memcpy(V2XBsmFieldPtr(bsm, F), &value, sizeof(value));
+}
+template <V2XBsmField F>
+static void sStoreText(V2XBsm& bsm, const char* value)
+{
+  char* p = (char*)V2XBsmFieldPtr(bsm, F);
+  strncpy(p, value != nullptr ? value : "", kBsmFields[F].size - 1);
+  p[kBsmFields[F].size - 1] = 0;
+}
 
-SOCKET SendSocket;
-sockaddr_in RecvAddr;
-int Port = 20000;
-const char* addr = "127.0.0.1";
+// One instance per field of V2X_BSM_FIELDS, see the Set_Func entries of the table.
+// The setters write into the current vehicle of the current CAPL block and
+// do nothing before dllInit.
+template <V2XBsmField F>
+void CAPLPASCAL appSetInt(int32_t value)
+{
+  V2XStatScope scope(kStatSetFirst + F);
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst == nullptr)
+  {
+    return;
+  }
+  sStoreInt<F>(inst->Vehicles().Current().bsm, value);
+  inst->BsmChanged(V2XBsmBit(F), kBsmFields[F].event);
+}
+template <V2XBsmField F>
+void CAPLPASCAL appSetText(const char* value)
+{
+  V2XStatScope scope(kStatSetFirst + F);
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst == nullptr)
+  {
+    return;
+  }
+  if (F == kBsmId)
+  {
+    inst->SelectVehicle(value);
+  }
+  sStoreText<F>(inst->Vehicles().Current().bsm, value);
+  inst->BsmChanged(V2XBsmBit(F), kBsmFields[F].event);
+}
+
+// Sets the whole BSM in one call. All fields are stored first, so the
+// receiver gets exactly one consistent datagram per vehicle update instead
+// of one per field.
+void CAPLEXPORT CAPLPASCAL appSetBsmFrame(int32_t latitude, int32_t longtitude, int32_t transmission_state, int32_t speed,
+                                          int32_t heading, int32_t latitude_acceleration, int32_t longtitude_acceleration, int32_t vehicle_class,
+                                          const char* events, int32_t response_type, int32_t light_use, const char* id,
+                                          int32_t sec_mark, int32_t elevation, int32_t accuracy_semi_major, int32_t accuracy_semi_minor,
+                                          int32_t accuracy_orientation, int32_t confidence_position, int32_t confidence_elevation, int32_t angle,
+                                          int32_t vert_acceleration, int32_t yaw_acceleration, int32_t brake_padel, const char* wheel_brakes,
+                                          int32_t traction, int32_t abs, int32_t scs, int32_t brake_boost,
+                                          int32_t aux_brakes, int32_t vehicle_width, int32_t vehicle_lenth, int32_t vehicle_height,
+                                          int32_t vehicle_fuel_type, const char* lights, int32_t siren_use)
+{
+  V2XStatScope scope(kStatSetBsmFrame);
+  CaplInstanceData* inst = GetCurrentInstance();
+  if (inst == nullptr)
+  {
+    return;
+  }
+  inst->SelectVehicle(id);
+  V2XBsm& bsm = inst->Vehicles().Current().bsm;
+  // the parameters are named like the members of V2XBsm
+#define V2X_BSM_STORE(field, member, type, key, scale, event, setName, getName, text) sStore##type<field>(bsm, member);
+  V2X_BSM_FIELDS(V2X_BSM_STORE)
+#undef V2X_BSM_STORE
+  inst->BsmChanged(kBsmAllFields, false);
+}
+
+// One instance per field of V2X_BSM_FIELDS, see the Get_Func entries of the table
+template <V2XBsmField F>
+int32_t CAPLPASCAL appGetField(void)
+{
+  V2XStatScope scope(kStatGetFirst + F);
+  return gReceiver.Get(F);
+}
+
+// Copies the latest received values of all fields in the order of the Get*
+// functions into 'values', consistent with one message. info[0] is the
+// sequence number of that message, info[1] its age in ms (0xffffffff if
+// nothing was received yet). Returns the number of values written.
+int32_t CAPLEXPORT CAPLPASCAL appGetBsmFrame(int32_t values[], int32_t count, uint32_t info[])
+{
+  V2XStatScope scope(kStatGetBsmFrame);
+  if (values==nullptr || info==nullptr)
+  {
+    return -1;
+  }
+
+  V2XBsmSnapshot snapshot;
+  gReceiver.Snapshot(snapshot);
+
+  int32_t written = (count<kBsmFieldCount) ? count : kBsmFieldCount;
+  if (written<0)
+  {
+    written = 0;
+  }
+  memcpy(values, snapshot.values, written*sizeof(int32_t));
+  info[0] = snapshot.sequence;
+  info[1] = (snapshot.time!=0) ? (uint32_t)((V2XNowNs() - snapshot.time) / 1000000u) : 0xffffffffu;
+  return written;
+}
 
-SOCKET RecvSocket;
-char RecvBuf[1024];
-int BufLen = 1024;
-sockaddr_in SenderAddr;
-int SendAddrSize = sizeof(SenderAddr);
-
-//to implement(Set Function)
-void CAPLEXPORT CAPLPASCAL appSetLongtitude(int32_t longtitude)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Longtitude"] = longtitude;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetLatiude(int32_t latitude)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Latitude"] = latitude;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetTransmissionState(int32_t transmission_state)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Transmission"] = transmission_state;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetSpeed(int32_t speed)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Speed"] = speed;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetHeading(int32_t heading)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Heading"] = heading;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetLatAcceleration(int32_t latitude_acceleration)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Acc_Lat"] = latitude_acceleration;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetLongAcceleration(int32_t longtitude_acceleration)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Acc_Lng"] = longtitude_acceleration;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetBasicVehicleClass(int32_t vehicle_class)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Veh_Class"] = vehicle_class;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetEvent(char* events)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Events"] = events;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetEmergencyExtensionsResponseType(int32_t response_type)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Response_Type"] = response_type;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetEmergencyExtensionsLightBarInUse(int32_t light_use)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Lights_Use"] = light_use;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-//reservation (Set Function)
-void CAPLEXPORT CAPLPASCAL appSetId(char* id)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Id"] = id;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetSecMark(int32_t sec_mark)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["time_stamp"] = sec_mark;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetElevation(int32_t elevation)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Elevation"] = elevation;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetSemiMajor(int32_t accuracy_semi_major)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Smajor_dev"] = accuracy_semi_major;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetSemiMinor(int32_t accuracy_semi_minor)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Sminor_dev"] = accuracy_semi_minor;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetOrientation(int32_t accuracy_orientation)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Smajor_Orien"] = accuracy_orientation;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetConfidencePosition(int32_t confidence_position)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Pos_Confidence_Pos"] = confidence_position;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetConfidenceElevation(int32_t confidence_elevation)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Pos_Confidence_Ele"] = confidence_elevation;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetWheelAngle(int32_t angle)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Wheel_Angle"] = angle;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetVertAcceleration(int32_t vert_acceleration)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Acc_Vert"] = vert_acceleration;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetYawAcceleration(int32_t yaw_acceleration)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Yaw_Rate"] = yaw_acceleration;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetBrakePadel(int32_t brake_padel)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Brake_Padel"] = brake_padel;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetWheelBrakes(char* wheel_brakes)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Wheel_Brakes"] = wheel_brakes;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetTraction(int32_t traction)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Traction"] = traction;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetABS(int32_t abs)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["ABS"] = abs;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetSCS(int32_t scs)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["SCS"] = scs;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetBrakeBoost(int32_t brake_boost)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Brake_Boost"] = brake_boost;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetAuxBrakes(int32_t aux_brakes)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Aux_Brakes"] = aux_brakes;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetVehicleWidth(int32_t vehicle_width)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Veh_Width"] = vehicle_width;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetVehicleLenth(int32_t vehicle_lenth)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Veh_Len"] = vehicle_lenth;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetVehicleHeight(int32_t vehicle_height)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Veh_Height"] = vehicle_height;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetVehicleFuelType(int32_t vehicle_fuel_type)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Veh_Fuel_Type"] = vehicle_fuel_type;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetLights(char* lights)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Lights"] = lights;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-void CAPLEXPORT CAPLPASCAL appSetSirenUse(int32_t siren_use)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	SendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = inet_addr(addr);
-	root["Siren_Use"] = siren_use;
-	std::string SendBuf = style_writer.write(root);
-	sendto(SendSocket, SendBuf.c_str(), SendBuf.size(), 0, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	closesocket(SendSocket);
-	WSACleanup();
-	return;
-}
-//to implement(Get Function)
-int32_t CAPLEXPORT CAPLPASCAL appGetLatiude(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Latiude"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetLongtitude(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Longtitude"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetTransmissionState(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Transmission"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetSpeed(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Speed"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetHeading(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Heading"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetLatAcceleration(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Acc_Lat"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetLongAcceleration(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Acc_Lng"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetBasicVehicleClass(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Veh_Class"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetEvent(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Events"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetEmergencyExtensionsResponseType(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Response_Type"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetEmergencyExtensionsLightBarInUse(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Lights_Use"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-//reservation (Get Function)
-int32_t CAPLEXPORT CAPLPASCAL appGetId(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Id"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetSecMark(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["time_stamp"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetElevation(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Elevation"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetSemiMajor(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Smajor_dev"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetSemiMinor(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Sminor_dev"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetOrientation(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Smajor_Orien"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetConfidencePosition(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Pos_Confidence_Pos"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetConfidenceElevation(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Pos_Confidence_Ele"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetWheelAngle(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Wheel_Angle"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetVertAcceleration(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Acc_Vert"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetYawAcceleration(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Yaw_Rate"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetBrakePadel(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Brake_Padel"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetWheelBrakes(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Wheel_Brakes"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetTraction(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Traction"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetABS(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["ABS"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetSCS(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["SCS"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetBrakeBoost(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Brake_Boost"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetAuxBrakes(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Aux_Brakes"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetVehicleWidth(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Veh_Width"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetVehicleLenth(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Veh_Len"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetVehicleHeight(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Veh_Height"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetVehicleFuelType(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Veh_Fuel_Type"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetLights(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Lights"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
-}
-int32_t CAPLEXPORT CAPLPASCAL appGetSirenUse(void)
-{
-	WSAStartup(MAKEWORD(2, 2), &wsaData);
-	RecvSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	RecvAddr.sin_family = AF_INET;
-	RecvAddr.sin_port = htons(Port);
-	RecvAddr.sin_addr.s_addr = htonl(INADDR_ANY);
-	bind(RecvSocket, (SOCKADDR*)&RecvAddr, sizeof(RecvAddr));
-	recvfrom(RecvSocket, RecvBuf, BufLen, 0, (SOCKADDR*)&SenderAddr, &SendAddrSize);
-	if (reader.parse(RecvBuf, root))
-	{
-		return root["Siren_Use"].asInt();
-	}
-	closesocket(RecvSocket);
-	WSACleanup();
+// Status returned by the Get*Ex functions
+enum V2XFieldStatus
+{
+  kFieldFresh         = 0,   // received within the stale age
+  kFieldStale         = 1,   // received, but older than the stale age
+  kFieldNeverReceived = 2
+};
+
+// upper bound of the timeout of Get*Ex. They run in the measurement
+// context, every ms of waiting stalls the whole simulation; a value that
+// arrives later is delivered by CALLBACK_OnBsm.
+static const int32_t kMaxGetTimeoutMs = 5;
+
+// One instance per field of V2X_BSM_FIELDS, see the Get_Func entries of the
+// table. If the value is not fresh, waits up to 'timeoutMs' (at most
+// kMaxGetTimeoutMs) for the field to arrive. result[0] is the value,
+// result[1] its age in ms (-1 if never received). Returns the
+// V2XFieldStatus.
+template <V2XBsmField F>
+int32_t CAPLPASCAL appGetFieldEx(int32_t timeoutMs, int32_t result[])
+{
+  V2XStatScope scope(kStatGetExFirst + F);
+  int32_t  value;
+  uint64_t time;
+  gReceiver.Field(F, value, time);
+
+  uint64_t now   = V2XNowNs();
+  uint64_t stale = (uint64_t)gStaleAgeMs.load(std::memory_order_relaxed) * 1000000u;
+  if ((time==0 || now - time>stale) && timeoutMs>0)
+  {
+    if (gReceiver.WaitForField(F, time, (uint32_t)((timeoutMs<kMaxGetTimeoutMs) ? timeoutMs : kMaxGetTimeoutMs)))
+    {
+      gReceiver.Field(F, value, time);
+    }
+    now = V2XNowNs();
+  }
+
+  int32_t status;
+  int32_t age;
+  if (time==0)
+  {
+    status = kFieldNeverReceived;
+    age    = -1;
+  }
+  else
+  {
+    uint64_t ms = (now - time) / 1000000u;
+    status = (now - time>stale) ? kFieldStale : kFieldFresh;
+    age    = (ms>0x7fffffff) ? 0x7fffffff : (int32_t)ms;
+  }
+  if (result!=nullptr)
+  {
+    result[0] = value;
+    result[1] = age;
+  }
+  return status;
 }
 
 // ============================================================================
@@ -1680,6 +1894,18 @@ int32_t CAPLEXPORT CAPLPASCAL appGetSirenUse(void)
 
 {0, 0}
 };*/
+// Set*/Get* entries of a field of V2X_BSM_FIELDS
+#define V2X_BSM_PARTYPE_Int   "L"
+#define V2X_BSM_PARTYPE_Text  "C"
+#define V2X_BSM_DEPTH_Int     ""
+#define V2X_BSM_DEPTH_Text    "\001"
+#define V2X_BSM_SET_ENTRY(field, member, type, key, scale, event, setName, getName, text) \
+  {setName, (CAPL_FARCALL)appSet##type<field>, "Set_Func", "This function will send " text " from CAPL to ROS", 'V', 1, V2X_BSM_PARTYPE_##type, V2X_BSM_DEPTH_##type, {#member}},
+#define V2X_BSM_GET_ENTRY(field, member, type, key, scale, event, setName, getName, text) \
+  {getName, (CAPL_FARCALL)appGetField<field>, "Get_Func", "This function will receive " text " from ROS to CAPL", 'L', 0, "V", "", {""}},
+#define V2X_BSM_GET_EX_ENTRY(field, member, type, key, scale, event, setName, getName, text) \
+  {getName "Ex", (CAPL_FARCALL)appGetFieldEx<field>, "Get_Func", "This function will receive " text " waiting at most timeout_ms but never longer than 5 ms, result[0] is the value and result[1] its age in ms. Returns 0 fresh, 1 stale, 2 never received", 'L', 2, "LL", "\000\001", {"timeout_ms","result"}},
+
 CAPL_DLL_INFO4 table[] = {
 {CDLL_VERSION_NAME, (CAPL_FARCALL)CDLL_VERSION, "", "", CAPL_DLL_CDECL, 0xabcd, CDLL_EXPORT },
 
@@ -1687,76 +1913,37 @@ CAPL_DLL_INFO4 table[] = {
   {"dllEnd",								(CAPL_FARCALL)appEnd,									"CAPL_DLL","This function will release the CAPL function handle in the CAPLDLL",'V', 1, "D", "", {"handle"}},
   {"dllSetValue",							(CAPL_FARCALL)appSetValue,								"CAPL_DLL","This function will call a callback functions",'L', 2, "DL", "", {"handle","x"}},
   {"dllReadData",							(CAPL_FARCALL)appReadData,								"CAPL_DLL","This function will call a callback functions",'L', 2, "DL", "", {"handle","x"}},
-  {"SetLatiude",							(CAPL_FARCALL)appSetLatiude,							"Set_Func","This function will send Latiude from CAPL to ROS",'V', 1, "L", "", {"latitude"}},
-  {"SetLongtitude",							(CAPL_FARCALL)appSetLongtitude,							"Set_Func","This function will send Longtitude from CAPL to ROS",'V', 1, "L", "", {"longtitude"}},
-  {"SetTransmissionState",					(CAPL_FARCALL)appSetTransmissionState,					"Set_Func","This function will send Transmission State from CAPL to ROS",'V', 1, "L", "", {"transmission_state"}},
-  {"SetSpeed",								(CAPL_FARCALL)appSetSpeed,								"Set_Func","This function will send Heading from CAPL to ROS",'V', 1, "L", "", {"speed"}},
-  {"SetHeading",							(CAPL_FARCALL)appSetHeading,							"Set_Func","This function will send Speed from CAPL to ROS",'V', 1, "L", "", {"heading"}},
-  {"SetLatAcceleration",					(CAPL_FARCALL)appSetLatAcceleration,					"Set_Func","This function will send Latitude Acceleration from CAPL to ROS",'V', 1, "L", "", {"latitude_acceleration"}},
-  {"SetLongAcceleration",					(CAPL_FARCALL)appSetLongAcceleration,					"Set_Func","This function will send Longitude Acceleration from CAPL to ROS",'V', 1, "L", "", {"longtitude_acceleration"}},
-  {"SetBasicVehicleClass",					(CAPL_FARCALL)appSetBasicVehicleClass,					"Set_Func","This function will send Basic Vehicle Class from CAPL to ROS",'V', 1, "L", "", {"vehicle_class"}},
-  {"SetEvent",								(CAPL_FARCALL)appSetEvent,								"Set_Func","This function will send Event from CAPL to ROS",'V', 1, "C", "\001", {"events"}},
-  {"SetEmergencyExtensionsResponseType",    (CAPL_FARCALL)appSetEmergencyExtensionsResponseType,    "Set_Func","This function will send Emergency Extensions Response Type from CAPL to ROS",'V', 1, "L", "", {"response_type"}},
-  {"SetEmergencyExtensionsLightBarInUse",   (CAPL_FARCALL)appSetEmergencyExtensionsLightBarInUse,   "Set_Func","This function will send Emergency Extensions Light Bar In Use from CAPL to ROS",'V', 1, "L", "", {"light_use"}},
-  {"SetId",									(CAPL_FARCALL)appSetId,									"Set_Func","This function will send Id from CAPL to ROS",'V', 1, "C", "\001", {"id"}},
-  {"SetSecMark",							(CAPL_FARCALL)appSetSecMark,							"Set_Func","This function will send Sec Mark from CAPL to ROS",'V', 1, "L", "", {"sec_mark"}},
-  {"SetElevation",							(CAPL_FARCALL)appSetElevation,							"Set_Func","This function will send Elevation from CAPL to ROS",'V', 1, "L", "", {"elevation"}},
-  {"SetSemiMajor",							(CAPL_FARCALL)appSetSemiMajor,							"Set_Func","This function will send Semi Major from CAPL to ROS",'V', 1, "L", "", {"accuracy_semi_major"}},
-  {"SetSemiMinor",							(CAPL_FARCALL)appSetSemiMinor,							"Set_Func","This function will send Semi Minor from CAPL to ROS",'V', 1, "L", "", {"accuracy_semi_minor"}},
-  {"SetOrientation",						(CAPL_FARCALL)appSetOrientation,						"Set_Func","This function will send Orientation from CAPL to ROS",'V', 1, "L", "", {"accuracy_orientation"}},
-  {"SetConfidencePosition",					(CAPL_FARCALL)appSetConfidencePosition,					"Set_Func","This function will send Confidence Position from CAPL to ROS",'V', 1, "L", "", {"confidence_position"}},
-  {"SetConfidenceElevation",				(CAPL_FARCALL)appSetConfidenceElevation,				"Set_Func","This function will send Confidence Elevation from CAPL to ROS",'V', 1, "L", "", {"confidence_elevation"}},
-  {"SetWheelAngle",							(CAPL_FARCALL)appSetWheelAngle,							"Set_Func","This function will send Wheel Angle from CAPL to ROS",'V', 1, "L", "", {"angle"}},
-  {"SetVertAcceleration",					(CAPL_FARCALL)appSetVertAcceleration,					"Set_Func","This function will send Vert Acceleration from CAPL to ROS",'V', 1, "L", "", {"vert_acceleration"}},
-  {"SetYawAcceleration",					(CAPL_FARCALL)appSetYawAcceleration,					"Set_Func","This function will send Yaw Acceleration from CAPL to ROS",'V', 1, "L", "", {"yaw_acceleration"}},
-  {"SetBrakePadel",							(CAPL_FARCALL)appSetBrakePadel,							"Set_Func","This function will send Brake Padel from CAPL to ROS",'V', 1, "L", "", {"brake_padel"}},
-  {"SetWheelBrakes",						(CAPL_FARCALL)appSetWheelBrakes,						"Set_Func","This function will send Wheel Brakes from CAPL to ROS",'V', 1, "C", "\001", {"wheel_brakes"}},
-  {"SetTraction",							(CAPL_FARCALL)appSetTraction,							"Set_Func","This function will send Traction from CAPL to ROS",'V', 1, "L", "", {"traction"}},
-  {"SetABS",								(CAPL_FARCALL)appSetABS,								"Set_Func","This function will send ABS from CAPL to ROS",'V', 1, "L", "", {"abs"}},
-  {"SetSCS",								(CAPL_FARCALL)appSetSCS,								"Set_Func","This function will send SCS from CAPL to ROS",'V', 1, "L", "", {"scs"}},
-  {"SetBrakeBoost",							(CAPL_FARCALL)appSetBrakeBoost,							"Set_Func","This function will send Brake Boost from CAPL to ROS",'V', 1, "L", "", {"brake_boost"}},
-  {"SetAuxBrakes",							(CAPL_FARCALL)appSetAuxBrakes,							"Set_Func","This function will send Aux Brakes from CAPL to ROS",'V', 1, "L", "", {"aux_brakes"}},
-  {"SetVehicleWidth",						(CAPL_FARCALL)appSetVehicleWidth,						"Set_Func","This function will send Vehicle Width from CAPL to ROS",'V', 1, "L", "", {"vehicle_width"}},
-  {"SetVehicleLenth",						(CAPL_FARCALL)appSetVehicleLenth,						"Set_Func","This function will send Vehicle Lenth from CAPL to ROS",'V', 1, "L", "", {"vehicle_lenth"}},
-  {"SetVehicleHeight",						(CAPL_FARCALL)appSetVehicleHeight,						"Set_Func","This function will send Vehicle Height from CAPL to ROS",'V', 1, "L", "", {"vehicle_height"}},
-  {"SetVehicleFuelType",					(CAPL_FARCALL)appSetVehicleFuelType,					"Set_Func","This function will send VehicleFuel Type from CAPL to ROS",'V', 1, "L", "", {"vehicle_fuel_type"}},
-  {"SetLights",								(CAPL_FARCALL)appSetLights,								"Set_Func","This function will send Lights from CAPL to ROS",'V', 1, "C", "\001", {"lights"}},
-  {"SetSetSirenUse",						(CAPL_FARCALL)appSetSirenUse,							"Set_Func","This function will send Siren Use from CAPL to ROS",'V', 1, "L", "", {"siren_use"}},
-  {"GetLatiude",							(CAPL_FARCALL)appGetLatiude,							"Get_Func","This function will receive Latiude from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetLongtitude",							(CAPL_FARCALL)appGetLongtitude,							"Get_Func","This function will receive Longtitude from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetTransmissionState",					(CAPL_FARCALL)appGetTransmissionState,					"Get_Func","This function will receive Transmission State from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetSpeed",								(CAPL_FARCALL)appGetSpeed,								"Get_Func","This function will receive Heading from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetHeading",							(CAPL_FARCALL)appGetHeading,							"Get_Func","This function will receive Speed from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetLatAcceleration",					(CAPL_FARCALL)appGetLatAcceleration,					"Get_Func","This function will receive Latitude Acceleration from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetLongAcceleration",					(CAPL_FARCALL)appGetLongAcceleration,					"Get_Func","This function will receive Longitude Acceleration from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetBasicVehicleClass",					(CAPL_FARCALL)appGetBasicVehicleClass,					"Get_Func","This function will receive Basic Vehicle Class from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetEvent",								(CAPL_FARCALL)appGetEvent,								"Get_Func","This function will receive Event from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetEmergencyExtensionsResponGetype",    (CAPL_FARCALL)appGetEmergencyExtensionsResponseType,    "Get_Func","This function will receive Emergency Extensions Response Type from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetEmergencyExtensionsLightBarInUse",   (CAPL_FARCALL)appGetEmergencyExtensionsLightBarInUse,   "Get_Func","This function will receive Emergency Extensions Light Bar In Use from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetId",									(CAPL_FARCALL)appGetId,									"Get_Func","This function will receive Id from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetSecMark",							(CAPL_FARCALL)appGetSecMark,							"Get_Func","This function will receive Sec Mark from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetElevation",							(CAPL_FARCALL)appGetElevation,							"Get_Func","This function will receive Elevation from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetSemiMajor",							(CAPL_FARCALL)appGetSemiMajor,							"Get_Func","This function will receive Semi Major from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetSemiMinor",							(CAPL_FARCALL)appGetSemiMinor,							"Get_Func","This function will receive Semi Minor from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetOrientation",						(CAPL_FARCALL)appGetOrientation,						"Get_Func","This function will receive Orientation from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetConfidencePosition",					(CAPL_FARCALL)appGetConfidencePosition,					"Get_Func","This function will receive Confidence Position from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetConfidenceElevation",				(CAPL_FARCALL)appGetConfidenceElevation,				"Get_Func","This function will receive Confidence Elevation from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetWheelAngle",							(CAPL_FARCALL)appGetWheelAngle,							"Get_Func","This function will receive Wheel Angle from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetVertAcceleration",					(CAPL_FARCALL)appGetVertAcceleration,					"Get_Func","This function will receive Vert Acceleration from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetYawAcceleration",					(CAPL_FARCALL)appGetYawAcceleration,					"Get_Func","This function will receive Yaw Acceleration from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetBrakePadel",							(CAPL_FARCALL)appGetBrakePadel,							"Get_Func","This function will receive Brake Padel from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetWheelBrakes",						(CAPL_FARCALL)appGetWheelBrakes,						"Get_Func","This function will receive Wheel Brakes from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetTraction",							(CAPL_FARCALL)appGetTraction,							"Get_Func","This function will receive Traction from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetABS",								(CAPL_FARCALL)appGetABS,								"Get_Func","This function will receive ABS from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetSCS",								(CAPL_FARCALL)appGetSCS,								"Get_Func","This function will receive SCS from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetBrakeBoost",							(CAPL_FARCALL)appGetBrakeBoost,							"Get_Func","This function will receive Brake Boost from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetAuxBrakes",							(CAPL_FARCALL)appGetAuxBrakes,							"Get_Func","This function will receive Aux Brakes from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetVehicleWidth",						(CAPL_FARCALL)appGetVehicleWidth,						"Get_Func","This function will receive Vehicle Width from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetVehicleLenth",						(CAPL_FARCALL)appGetVehicleLenth,						"Get_Func","This function will receive Vehicle Lenth from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetVehicleHeight",						(CAPL_FARCALL)appGetVehicleHeight,						"Get_Func","This function will receive Vehicle Height from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetVehicleFuelType",					(CAPL_FARCALL)appGetVehicleFuelType,					"Get_Func","This function will receive VehicleFuel Type from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetLights",								(CAPL_FARCALL)appGetLights,								"Get_Func","This function will receive Lights from ROS to CAPL",'L', 0, "V", "", {""}},
-  {"GetGetSirenUse",						(CAPL_FARCALL)appGetSirenUse,							"Get_Func","This function will receive Siren Use from ROS to CAPL",'L', 0, "V", "", {""}},
+  {"dllSelectInstance",						(CAPL_FARCALL)appSelectInstance,						"CAPL_DLL","This function will make the V2X functions called afterwards work on the CAPL block of the handle, call it first in every event procedure if several CAPL blocks use the DLL",'V', 1, "D", "", {"handle"}},
+  {"dllDispatchBsm",						(CAPL_FARCALL)appDispatchBsm,							"CAPL_DLL","This function will call CALLBACK_OnBsm if new V2X data was received",'V', 0, "", "", {""}},
+  {"dllSetPublishRate",						(CAPL_FARCALL)appSetPublishRate,						"CAPL_DLL","This function will set the rate of the periodic BSM frame in Hz, 0 sends on every Set call",'V', 1, "L", "", {"rate_hz"}},
+  {"dllSetImmediateEvents",					(CAPL_FARCALL)appSetImmediateEvents,					"CAPL_DLL","This function will enable immediate sends of event fields besides the periodic BSM frame",'V', 1, "L", "", {"enable"}},
+  {"dllSetDeltaMode",						(CAPL_FARCALL)appSetDeltaMode,							"CAPL_DLL","This function will send only changed fields with a keyframe every n messages, 0 sends the whole document",'V', 1, "L", "", {"keyframe_interval"}},
+  {"dllSetWireFormat",						(CAPL_FARCALL)appSetWireFormat,							"CAPL_DLL","This function will select the format of the sent BSM, 0: JSON, 1: binary frame",'V', 1, "L", "", {"format"}},
+  {"dllSetMultiVehicle",					(CAPL_FARCALL)appSetMultiVehicle,						"CAPL_DLL","This function will keep one BSM per vehicle id set with SetId, all vehicles are sent every period",'V', 1, "L", "", {"enable"}},
+  {"dllSetSocketBuffers",					(CAPL_FARCALL)appSetSocketBuffers,						"CAPL_DLL","This function will set the receive and send buffer sizes of the UDP sockets in bytes, 0 keeps a size",'V', 2, "LL", "", {"receive_bytes","send_bytes"}},
+  {"dllSetLinkHeader",						(CAPL_FARCALL)appSetLinkHeader,							"CAPL_DLL","This function will put a header with sequence number and send time in front of every sent datagram, off by default",'V', 1, "L", "", {"enable"}},
+  {"dllSetReceiveMode",						(CAPL_FARCALL)appSetReceiveMode,						"CAPL_DLL","This function will receive in a thread (0) or in a timer of the measurement that never blocks (1), the Get Ex functions then do not wait",'L', 1, "L", "", {"mode"}},
+  {"dllSetStaleAge",						(CAPL_FARCALL)appSetStaleAge,							"CAPL_DLL","This function will set the age in ms after which the Get Ex functions report a received value as stale",'V', 1, "L", "", {"age_ms"}},
+  {"dllLoadSignalMap",						(CAPL_FARCALL)appLoadSignalMap,							"CAPL_DLL","This function will map bus signals onto BSM fields by the V2XField and V2XFactor signal attributes of a DBC, returns the number of mapped signals",'L', 1, "C", "\001", {"path"}},
+  {"dllOnBusMessage",						(CAPL_FARCALL)appOnBusMessage,							"CAPL_DLL","This function will decode the mapped signals of a bus frame into the BSM, call it from on message * with the id, the number of data bytes and the data bytes",'L', 3, "DLB", "\000\000\001", {"id","length","data"}},
+  {"dllSetDestinations",					(CAPL_FARCALL)appSetDestinations,						"CAPL_DLL","This function will send every datagram to a list of addr:port or to a multicast group instead of the default destination, an empty list goes back to it, returns the number of destinations",'L', 1, "C", "\001", {"destinations"}},
+  {"dllSetMulticast",						(CAPL_FARCALL)appSetMulticast,							"CAPL_DLL","This function will set the TTL and the loopback to consumers on the same host of multicast datagrams, and the address of the outgoing interface, empty for the default",'L', 3, "LLC", "\000\000\001", {"ttl","loopback","interface"}},
+  {"dllSetSysVarNamespace",					(CAPL_FARCALL)appSetSysVarNamespace,					"CAPL_DLL","This function will write the received fields into system variables of a namespace like V2X::RemoteBsm when they change, an empty path stops it",'L', 1, "C", "\001", {"path"}},
+  {"dllSetSharedMemory",					(CAPL_FARCALL)appSetSharedMemory,						"CAPL_DLL","This function will send binary BSM frames through a shared memory ring instead of UDP, slots applies to a new ring only, an empty name goes back to UDP",'L', 2, "CL", "\001\000", {"name","slots"}},
+  {"dllGetStats",							(CAPL_FARCALL)appGetStats,								"CAPL_DLL","This function will read calls and latency percentiles in ns of a DLL function like SetSpeed, LinkLatency is the one-way latency of the received datagrams",'L', 3, "CDL", "\001\001\000", {"name","values","count"}},
+  {"dllGetCounters",						(CAPL_FARCALL)appGetCounters,							"CAPL_DLL","This function will read the bytes and datagrams sent and received, send errors, parse failures, dropped capture records and the datagrams lost, duplicated and reordered on the link",'L', 2, "DL", "\001\000", {"values","count"}},
+  {"dllResetStats",							(CAPL_FARCALL)appResetStats,							"CAPL_DLL","This function will reset all statistics of the DLL",'V', 0, "", "", {""}},
+  {"dllSetStatsDump",						(CAPL_FARCALL)appSetStatsDump,							"CAPL_DLL","This function will append all statistics to a file every period_ms, an empty path stops it",'L', 2, "CL", "\001\000", {"path","period_ms"}},
+  {"dllStartCapture",						(CAPL_FARCALL)appStartCapture,							"CAPL_DLL","This function will write every V2X datagram sent and received to a binary log file",'L', 1, "C", "\001", {"path"}},
+  {"dllStopCapture",						(CAPL_FARCALL)appStopCapture,							"CAPL_DLL","This function will finish the capture log with its index",'V', 0, "", "", {""}},
+  {"dllStartReplay",						(CAPL_FARCALL)appStartReplay,							"CAPL_DLL","This function will feed the received datagrams of a capture log into the Get functions at speed times the recorded rate, 0 as fast as possible",'L', 3, "CLL", "\001\000\000", {"path","speed","start_ms"}},
+  {"dllStopReplay",							(CAPL_FARCALL)appStopReplay,							"CAPL_DLL","This function will stop the replay and publish live V2X data again",'V', 0, "", "", {""}},
+  {"dllIsReplaying",						(CAPL_FARCALL)appIsReplaying,							"CAPL_DLL","This function will return 1 while a replay runs",'L', 0, "", "", {""}},
+  V2X_BSM_FIELDS(V2X_BSM_SET_ENTRY)
+  {"SetBsmFrame",							(CAPL_FARCALL)appSetBsmFrame,							"Set_Func","This function will send all BSM fields from CAPL to ROS in one message",'V', 35, "LLLLLLLLCLLCLLLLLLLLLLLCLLLLLLLLLCL", "\000\000\000\000\000\000\000\000\001\000\000\001\000\000\000\000\000\000\000\000\000\000\000\001\000\000\000\000\000\000\000\000\000\001\000", {"latitude","longtitude","transmission_state","speed","heading","latitude_acceleration","longtitude_acceleration","vehicle_class","events","response_type","light_use","id","sec_mark","elevation","accuracy_semi_major","accuracy_semi_minor","accuracy_orientation","confidence_position","confidence_elevation","angle","vert_acceleration","yaw_acceleration","brake_padel","wheel_brakes","traction","abs","scs","brake_boost","aux_brakes","vehicle_width","vehicle_lenth","vehicle_height","vehicle_fuel_type","lights","siren_use"}},
+  V2X_BSM_FIELDS(V2X_BSM_GET_ENTRY)
+  V2X_BSM_FIELDS(V2X_BSM_GET_EX_ENTRY)
+  {"GetBsmFrame",							(CAPL_FARCALL)appGetBsmFrame,							"Get_Func","This function will read all received BSM fields of one message, info[0] is its sequence number and info[1] its age in ms",'L', 3, "LLD", "\001\000\001", {"values","count","info"}},
 
 {0, 0}
 };
@@ -0,0 +1,154 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_bsm.h
+|
+|            Fields of the basic safety message (BSM) exchanged between the
+|            CAPL DLL and the ROS / OBU bridge.
+|
+|            V2X_BSM_FIELDS is the single registry of the fields. The field
+|            enum, the packed V2XBsm struct, the descriptor table
+|            kBsmFields and, in capldll.cpp, the Set and Get exports and their
+|            CAPL table entries are all generated from it.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Capacity of a text field including the terminating NUL
+static const size_t kBsmTextLength = 16;
+
+// ============================================================================
+// V2X_BSM_FIELDS(X)
+//
+// One X(...) per field, in the order of the Set*/Get* functions in the CAPL
+// export table (which is also the order on the binary wire):
+//
+//   field    V2XBsmField enumerator
+//   member   member of V2XBsm, also the CAPL parameter name of the setter
+//   type     Int: int32 value, CAPL 'long'
+//            Text: string, CAPL 'char[]', sent as JSON string
+//   key      JSON key
+//   scale    physical unit of one LSB (informational, values stay raw)
+//   event    true if a change is sent at once while the publisher runs
+//   setName  CAPL name of the setter
+//   getName  CAPL name of the getter
+//   text     name used in the function hints
+//
+// Some CAPL names contain typos ("SetSetSirenUse", ...). They are kept
+// because existing CAPL programs call them.
+// ============================================================================
+#define V2X_BSM_FIELDS(X) \
+  X(kBsmLatitude,         latitude,                Int,  "Latitude",           1e-7,    false, "SetLatiude",                          "GetLatiude",                          "Latiude") \
+  X(kBsmLongtitude,       longtitude,              Int,  "Longtitude",         1e-7,    false, "SetLongtitude",                       "GetLongtitude",                       "Longtitude") \
+  X(kBsmTransmission,     transmission_state,      Int,  "Transmission",       1,       false, "SetTransmissionState",                "GetTransmissionState",                "Transmission State") \
+  X(kBsmSpeed,            speed,                   Int,  "Speed",              0.02,    false, "SetSpeed",                            "GetSpeed",                            "Speed") \
+  X(kBsmHeading,          heading,                 Int,  "Heading",            0.0125,  false, "SetHeading",                          "GetHeading",                          "Heading") \
+  X(kBsmAccLat,           latitude_acceleration,   Int,  "Acc_Lat",            0.01,    false, "SetLatAcceleration",                  "GetLatAcceleration",                  "Latitude Acceleration") \
+  X(kBsmAccLng,           longtitude_acceleration, Int,  "Acc_Lng",            0.01,    false, "SetLongAcceleration",                 "GetLongAcceleration",                 "Longitude Acceleration") \
+  X(kBsmVehClass,         vehicle_class,           Int,  "Veh_Class",          1,       false, "SetBasicVehicleClass",                "GetBasicVehicleClass",                "Basic Vehicle Class") \
+  X(kBsmEvents,           events,                  Text, "Events",             1,       true,  "SetEvent",                            "GetEvent",                            "Event") \
+  X(kBsmResponseType,     response_type,           Int,  "Response_Type",      1,       true,  "SetEmergencyExtensionsResponseType",  "GetEmergencyExtensionsResponGetype",  "Emergency Extensions Response Type") \
+  X(kBsmLightsUse,        light_use,               Int,  "Lights_Use",         1,       true,  "SetEmergencyExtensionsLightBarInUse", "GetEmergencyExtensionsLightBarInUse", "Emergency Extensions Light Bar In Use") \
+  X(kBsmId,               id,                      Text, "Id",                 1,       false, "SetId",                               "GetId",                               "Id") \
+  X(kBsmTimeStamp,        sec_mark,                Int,  "time_stamp",         0.001,   false, "SetSecMark",                          "GetSecMark",                          "Sec Mark") \
+  X(kBsmElevation,        elevation,               Int,  "Elevation",          0.1,     false, "SetElevation",                        "GetElevation",                        "Elevation") \
+  X(kBsmSmajorDev,        accuracy_semi_major,     Int,  "Smajor_dev",         0.05,    false, "SetSemiMajor",                        "GetSemiMajor",                        "Semi Major") \
+  X(kBsmSminorDev,        accuracy_semi_minor,     Int,  "Sminor_dev",         0.05,    false, "SetSemiMinor",                        "GetSemiMinor",                        "Semi Minor") \
+  X(kBsmSmajorOrien,      accuracy_orientation,    Int,  "Smajor_Orien",       0.0054932479, false, "SetOrientation",                 "GetOrientation",                      "Orientation") \
+  X(kBsmPosConfidencePos, confidence_position,     Int,  "Pos_Confidence_Pos", 1,       false, "SetConfidencePosition",               "GetConfidencePosition",               "Confidence Position") \
+  X(kBsmPosConfidenceEle, confidence_elevation,    Int,  "Pos_Confidence_Ele", 1,       false, "SetConfidenceElevation",              "GetConfidenceElevation",              "Confidence Elevation") \
+  X(kBsmWheelAngle,       angle,                   Int,  "Wheel_Angle",        1.5,     false, "SetWheelAngle",                       "GetWheelAngle",                       "Wheel Angle") \
+  X(kBsmAccVert,          vert_acceleration,       Int,  "Acc_Vert",           0.01,    false, "SetVertAcceleration",                 "GetVertAcceleration",                 "Vert Acceleration") \
+  X(kBsmYawRate,          yaw_acceleration,        Int,  "Yaw_Rate",           0.01,    false, "SetYawAcceleration",                  "GetYawAcceleration",                  "Yaw Acceleration") \
+  X(kBsmBrakePadel,       brake_padel,             Int,  "Brake_Padel",        1,       false, "SetBrakePadel",                       "GetBrakePadel",                       "Brake Padel") \
+  X(kBsmWheelBrakes,      wheel_brakes,            Text, "Wheel_Brakes",       1,       false, "SetWheelBrakes",                      "GetWheelBrakes",                      "Wheel Brakes") \
+  X(kBsmTraction,         traction,                Int,  "Traction",           1,       false, "SetTraction",                         "GetTraction",                         "Traction") \
+  X(kBsmABS,              abs,                     Int,  "ABS",                1,       false, "SetABS",                              "GetABS",                              "ABS") \
+  X(kBsmSCS,              scs,                     Int,  "SCS",                1,       false, "SetSCS",                              "GetSCS",                              "SCS") \
+  X(kBsmBrakeBoost,       brake_boost,             Int,  "Brake_Boost",        1,       false, "SetBrakeBoost",                       "GetBrakeBoost",                       "Brake Boost") \
+  X(kBsmAuxBrakes,        aux_brakes,              Int,  "Aux_Brakes",         1,       false, "SetAuxBrakes",                        "GetAuxBrakes",                        "Aux Brakes") \
+  X(kBsmVehWidth,         vehicle_width,           Int,  "Veh_Width",          0.01,    false, "SetVehicleWidth",                     "GetVehicleWidth",                     "Vehicle Width") \
+  X(kBsmVehLen,           vehicle_lenth,           Int,  "Veh_Len",            0.01,    false, "SetVehicleLenth",                     "GetVehicleLenth",                     "Vehicle Lenth") \
+  X(kBsmVehHeight,        vehicle_height,          Int,  "Veh_Height",         0.05,    false, "SetVehicleHeight",                    "GetVehicleHeight",                    "Vehicle Height") \
+  X(kBsmVehFuelType,      vehicle_fuel_type,       Int,  "Veh_Fuel_Type",      1,       false, "SetVehicleFuelType",                  "GetVehicleFuelType",                  "VehicleFuel Type") \
+  X(kBsmLights,           lights,                  Text, "Lights",             1,       false, "SetLights",                           "GetLights",                           "Lights") \
+  X(kBsmSirenUse,         siren_use,               Int,  "Siren_Use",          1,       true,  "SetSetSirenUse",                      "GetGetSirenUse",                      "Siren Use")
+
+// Per type helpers for the registry: C type of the V2XBsm member, CAPL
+// type letter and array depth of the setter parameter
+#define V2X_BSM_MEMBER_Int(member)   int32_t member;
+#define V2X_BSM_MEMBER_Text(member)  char    member[kBsmTextLength];
+#define V2X_BSM_CAPL_Int             'L'
+#define V2X_BSM_CAPL_Text            'C'
+
+
+enum V2XBsmField
+{
+#define V2X_BSM_ENUM(field, member, type, key, scale, event, setName, getName, text) field,
+  V2X_BSM_FIELDS(V2X_BSM_ENUM)
+#undef V2X_BSM_ENUM
+
+  kBsmFieldCount
+};
+
+
+// ============================================================================
+// V2XBsm
+//
+// Last value of every field, packed without padding. Text fields are NUL
+// terminated.
+// ============================================================================
+#pragma pack(push, 1)
+struct V2XBsm
+{
+#define V2X_BSM_MEMBER(field, member, type, key, scale, event, setName, getName, text) V2X_BSM_MEMBER_##type(member)
+  V2X_BSM_FIELDS(V2X_BSM_MEMBER)
+#undef V2X_BSM_MEMBER
+};
+#pragma pack(pop)
+
+
+// ============================================================================
+// V2XBsmFieldInfo
+//
+// Descriptor of a field, kBsmFields is indexed by V2XBsmField. All entries
+// are constant, so kBsmFields[F].offset folds into the code of a template
+// instantiated for field F.
+// ============================================================================
+struct V2XBsmFieldInfo
+{
+  const char* key;       // JSON key
+  char        caplType;  // 'L' or 'C'
+  double      scale;     // physical unit of one LSB
+  bool        event;     // sent at once while the publisher runs
+  size_t      offset;    // offset in V2XBsm
+  size_t      size;      // size in V2XBsm
+};
+
+static const V2XBsmFieldInfo kBsmFields[kBsmFieldCount] =
+{
+#define V2X_BSM_INFO(field, member, type, key, scale, event, setName, getName, text) \
+  { key, V2X_BSM_CAPL_##type, scale, event, offsetof(V2XBsm, member), sizeof(((V2XBsm*)0)->member) },
+  V2X_BSM_FIELDS(V2X_BSM_INFO)
+#undef V2X_BSM_INFO
+};
+
+// Pointer to field 'field' of 'bsm'
+inline void*       V2XBsmFieldPtr(V2XBsm& bsm, V2XBsmField field)       { return (uint8_t*)&bsm + kBsmFields[field].offset; }
+inline const void* V2XBsmFieldPtr(const V2XBsm& bsm, V2XBsmField field) { return (const uint8_t*)&bsm + kBsmFields[field].offset; }
+
+
+// Set of fields, bit n stands for V2XBsmField n
+typedef uint64_t V2XBsmMask;
+
+inline V2XBsmMask V2XBsmBit(V2XBsmField field) { return (V2XBsmMask)1 << field; }
+
+static const V2XBsmMask kBsmAllFields = ((V2XBsmMask)1 << kBsmFieldCount) - 1;
+
+// Additional keys of the delta protocol. Every message carries a sequence
+// number, a keyframe holds all fields, any other message only the fields
+// changed since the previous message.
+static const char* const kBsmSeqKey      = "Seq";
+static const char* const kBsmKeyframeKey = "Keyframe";
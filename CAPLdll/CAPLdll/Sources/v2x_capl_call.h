@@ -0,0 +1,320 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_capl_call.h
+|
+|            Typed calls of CAPL callback functions. VIACaplFunction::Call
+|            takes the parameters as a raw call stack; its layout is
+|            computed here at compile time from the C++ parameter types:
+|
+|              32 bit  the first parameter is the last one in memory, every
+|                      parameter takes its size rounded up to 4 bytes, an
+|                      array 8 bytes (number of elements, pointer)
+|              64 bit  the first parameter is the first one in memory,
+|                      every parameter takes 8 bytes, an array 16 bytes
+|                      (pointer, number of elements)
+|
+|            The layout follows the pointer size of the build (X64 in
+|            capldll.cpp).
+|
+|            Supported parameters and their CAPL types:
+|
+|              int32_t 'L', uint32_t 'D', int16_t 'I', uint16_t 'W',
+|              uint8_t 'B', char 'C', double 'F'
+|              V2XCaplArray<T>   array of one of the above, see
+|                                V2XCaplArrayOf, V2XCaplString
+|              structs           as byte array, see V2XCaplBytesOf
+|
+|            Example:
+|
+|              V2XCaplFunction<void(uint32_t, V2XCaplArray<char>)> f;
+|              f.Get(capl, "CALLBACK_Info");     // checks the signature once
+|              f(nullptr, 1, V2XCaplString("text"));
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "../Includes/cdll.h"
+#include "../Includes/VIA.h"
+#include "../Includes/VIA_CDLL.h"
+
+
+// ============================================================================
+// V2XCaplArray
+//
+// Array parameter, CAPL reads 'count' elements of 'data'. The caller keeps
+// the data alive during the call.
+// ============================================================================
+template <typename T>
+struct V2XCaplArray
+{
+  const T* data;
+  uint32_t count;
+};
+
+template <typename T>
+V2XCaplArray<T> V2XCaplArrayOf(const T* data, uint32_t count)
+{
+  V2XCaplArray<T> array = { data, count };
+  return array;
+}
+
+// A string with its terminating NUL
+inline V2XCaplArray<char> V2XCaplString(const char* text)
+{
+  return V2XCaplArrayOf(text, (uint32_t)strlen(text) + 1);
+}
+
+// A plain struct as 'byte data[]', CAPL copies it with memcpy_off
+template <typename S>
+V2XCaplArray<uint8_t> V2XCaplBytesOf(const S& data)
+{
+  static_assert(std::is_pod<S>::value, "only plain structs can be passed to CAPL");
+  return V2XCaplArrayOf((const uint8_t*)&data, (uint32_t)sizeof(S));
+}
+
+
+// ============================================================================
+// V2XCaplParam
+//
+// CAPL type and stack slot of a parameter type. Not defined for types CAPL
+// cannot take, so they fail to compile.
+// ============================================================================
+static const bool kCaplStack64 = sizeof(void*)==8;
+
+template <typename T, char Type>
+struct V2XCaplScalar
+{
+  static const char kType = Type;
+  enum { kSize = kCaplStack64 ? 8 : (sizeof(T) + 3) & ~3 };
+
+  static void Write(uint8_t* slot, T value)
+  {
+    memcpy(slot, &value, sizeof(T));
+  }
+};
+
+template <typename T> struct V2XCaplParam;
+template <> struct V2XCaplParam<int32_t>  : V2XCaplScalar<int32_t,  'L'> {};
+template <> struct V2XCaplParam<uint32_t> : V2XCaplScalar<uint32_t, 'D'> {};
+template <> struct V2XCaplParam<int16_t>  : V2XCaplScalar<int16_t,  'I'> {};
+template <> struct V2XCaplParam<uint16_t> : V2XCaplScalar<uint16_t, 'W'> {};
+template <> struct V2XCaplParam<uint8_t>  : V2XCaplScalar<uint8_t,  'B'> {};
+template <> struct V2XCaplParam<char>     : V2XCaplScalar<char,     'C'> {};
+template <> struct V2XCaplParam<double>   : V2XCaplScalar<double,   'F'> {};
+
+template <typename T>
+struct V2XCaplParam< V2XCaplArray<T> >
+{
+  static const char kType = V2XCaplParam<T>::kType;
+  enum { kSize = kCaplStack64 ? 16 : 8 };
+
+  static void Write(uint8_t* slot, const V2XCaplArray<T>& array)
+  {
+    if (kCaplStack64)
+    {
+      memcpy(slot,   &array.data,  sizeof(array.data));
+      memcpy(slot+8, &array.count, 4);
+    }
+    else
+    {
+      memcpy(slot,   &array.count, 4);
+      memcpy(slot+4, &array.data,  sizeof(array.data));
+    }
+  }
+};
+
+
+// ============================================================================
+// V2XCaplStack
+//
+// Size and writer of the call stack of a parameter list. The offsets are
+// constants, Write() compiles to a few stores.
+// ============================================================================
+template <typename... Args> struct V2XCaplStack;
+
+template <>
+struct V2XCaplStack<>
+{
+  enum { kSize = 0 };
+  static void Write(uint8_t*) {}
+};
+
+template <typename T, typename... Rest>
+struct V2XCaplStack<T, Rest...>
+{
+  enum { kSize = V2XCaplParam<T>::kSize + V2XCaplStack<Rest...>::kSize };
+
+  static void Write(uint8_t* stack, const T& first, const Rest&... rest)
+  {
+    if (kCaplStack64)
+    {
+      V2XCaplParam<T>::Write(stack, first);
+      V2XCaplStack<Rest...>::Write(stack + V2XCaplParam<T>::kSize, rest...);
+    }
+    else
+    {
+      V2XCaplStack<Rest...>::Write(stack, rest...);
+      V2XCaplParam<T>::Write(stack + V2XCaplStack<Rest...>::kSize, first);
+    }
+  }
+};
+
+
+// ============================================================================
+// V2XCaplResult
+//
+// CAPL type of a result and the Call variant that returns it
+// ============================================================================
+template <typename R> struct V2XCaplResult;
+
+template <>
+struct V2XCaplResult<void>
+{
+  typedef uint32_t Type;   // not written
+  static const char kType = 'V';
+  static VIAResult Call(VIACaplFunction* f, void* stack, Type*) { Type unused; return f->Call(&unused, stack); }
+};
+
+template <typename R, char T>
+struct V2XCaplIntResult
+{
+  typedef R Type;
+  static const char kType = T;
+  static VIAResult Call(VIACaplFunction* f, void* stack, Type* result)
+  {
+    uint32 value = 0;
+    VIAResult rc = f->Call(&value, stack);
+    if (result!=nullptr)
+    {
+      *result = (R)value;
+    }
+    return rc;
+  }
+};
+template <> struct V2XCaplResult<int32_t>  : V2XCaplIntResult<int32_t,  'L'> {};
+template <> struct V2XCaplResult<uint32_t> : V2XCaplIntResult<uint32_t, 'D'> {};
+
+template <>
+struct V2XCaplResult<double>
+{
+  typedef double Type;
+  static const char kType = 'F';
+  static VIAResult Call(VIACaplFunction* f, void* stack, Type* result)
+  {
+    double value = 0;
+    VIAResult rc = f->CallReturnsDouble(&value, stack);
+    if (result!=nullptr)
+    {
+      *result = value;
+    }
+    return rc;
+  }
+};
+
+
+// Calls 'function' with 'args' laid out as its call stack. 'result' may be
+// nullptr. The signature is not checked, see V2XCaplFunction.
+template <typename Ret, typename... Args>
+VIAResult V2XInvokeCapl(VIACaplFunction* function, typename V2XCaplResult<Ret>::Type* result, const Args&... args)
+{
+  typedef V2XCaplStack<Args...> Stack;
+  uint64_t stack[(Stack::kSize + 7) / 8 + 1];   // zeroed, so the padding is defined
+  memset(stack, 0, sizeof(stack));
+  Stack::Write((uint8_t*)stack, args...);
+  return V2XCaplResult<Ret>::Call(function, stack, result);
+}
+
+
+// ============================================================================
+// V2XCaplFunction
+//
+// Handle of a CAPL function with the signature Ret(Args...). Get() checks
+// the signature reported by CAPL once; a call through the handle only
+// builds the stack.
+// ============================================================================
+template <typename Signature> class V2XCaplFunction;
+
+template <typename Ret, typename... Args>
+class V2XCaplFunction<Ret(Args...)>
+{
+public:
+  typedef typename V2XCaplResult<Ret>::Type Result;
+
+  V2XCaplFunction() : mCapl(nullptr), mFunction(nullptr) {}
+
+  // Gets the CAPL function 'name'. Returns false and stays invalid if the
+  // CAPL program has no such function or it has another signature.
+  bool Get(VIACapl* capl, const char* name)
+  {
+    Release();
+    VIACaplFunction* f = nullptr;
+    if (capl==nullptr || capl->GetCaplFunction(&f, name)!=kVIA_OK || f==nullptr)
+    {
+      return false;
+    }
+    if (!Matches(f))
+    {
+      capl->ReleaseCaplFunction(f);
+      return false;
+    }
+    mCapl     = capl;
+    mFunction = f;
+    return true;
+  }
+
+  // The handle stays valid until the end of the measurement or Release(),
+  // it is not released on destruction
+  void Release()
+  {
+    if (mFunction!=nullptr)
+    {
+      mCapl->ReleaseCaplFunction(mFunction);
+    }
+    mCapl     = nullptr;
+    mFunction = nullptr;
+  }
+
+  bool IsValid() const { return mFunction!=nullptr; }
+
+  // Calls the function, kVIA_ObjectNotFound if the handle is not valid.
+  // 'result' may be nullptr.
+  VIAResult operator()(Result* result, Args... args) const
+  {
+    if (mFunction==nullptr)
+    {
+      return kVIA_ObjectNotFound;
+    }
+    return V2XInvokeCapl<Ret, Args...>(mFunction, result, args...);
+  }
+
+private:
+  V2XCaplFunction(const V2XCaplFunction&);     // not copyable
+  V2XCaplFunction& operator=(const V2XCaplFunction&);
+
+  static bool Matches(VIACaplFunction* f)
+  {
+    const char types[] = { V2XCaplParam<Args>::kType..., 0 };
+    char       type;
+    int32      count;
+    if (f->ResultType(&type)!=kVIA_OK || type!=V2XCaplResult<Ret>::kType ||
+        f->ParamCount(&count)!=kVIA_OK || count!=(int32)sizeof...(Args))
+    {
+      return false;
+    }
+    for (int32 i=0; i<count; ++i)
+    {
+      if (f->ParamType(&type, i)!=kVIA_OK || type!=types[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  VIACapl*         mCapl;
+  VIACaplFunction* mFunction;
+};
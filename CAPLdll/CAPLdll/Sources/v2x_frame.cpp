@@ -0,0 +1,130 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_frame.cpp
+|
+|            Binary wire format of the BSM.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_frame.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static const uint8_t kMagic[4]   = { 'V', '2', 'X', 'B' };
+static const size_t  kHeaderSize = 20;
+
+static_assert(kHeaderSize + 4*(kBsmFieldCount-1) + kBsmIdLength==kBsmFrameSize, "layout of version 1 changed");
+
+
+static void sPut32(uint8_t* p, uint32_t v)
+{
+  p[0] = (uint8_t)(v);
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t sGet32(const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Offset of a field in the frame, the id takes 8 instead of 4 bytes
+static size_t sFieldOffset(int32_t field)
+{
+  size_t offset = kHeaderSize + 4*field;
+  if (field>kBsmId)
+  {
+    offset += kBsmIdLength - 4;
+  }
+  return offset;
+}
+
+
+size_t V2XEncodeFrame(const V2XBsmFrame& frame, void* buffer, size_t size)
+{
+  if (size<kBsmFrameSize)
+  {
+    return 0;
+  }
+
+  uint8_t* p = (uint8_t*)buffer;
+  memcpy(p, kMagic, sizeof(kMagic));
+  p[4] = kBsmFrameVersion;
+  p[5] = frame.flags;
+  p[6] = 0;
+  p[7] = 0;
+  sPut32(p+8,  frame.seq);
+  sPut32(p+12, (uint32_t)frame.present);
+  sPut32(p+16, (uint32_t)(frame.present >> 32));
+
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    if (i==kBsmId)
+    {
+      memcpy(p+sFieldOffset(i), frame.id, kBsmIdLength);
+    }
+    else
+    {
+      sPut32(p+sFieldOffset(i), (uint32_t)frame.values[i]);
+    }
+  }
+  return kBsmFrameSize;
+}
+
+bool V2XDecodeFrame(const void* data, size_t length, V2XBsmFrame& frame)
+{
+  const uint8_t* p = (const uint8_t*)data;
+  if (length<kBsmFrameSize || memcmp(p, kMagic, sizeof(kMagic))!=0 || p[4]<kBsmFrameVersion)
+  {
+    return false;
+  }
+
+  frame.flags   = p[5];
+  frame.seq     = sGet32(p+8);
+  frame.present = ((V2XBsmMask)sGet32(p+12) | ((V2XBsmMask)sGet32(p+16) << 32)) & kBsmAllFields;
+
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    if (i==kBsmId)
+    {
+      memcpy(frame.id, p+sFieldOffset(i), kBsmIdLength);
+      frame.values[i] = 0;
+    }
+    else
+    {
+      frame.values[i] = (int32_t)sGet32(p+sFieldOffset(i));
+    }
+  }
+  return true;
+}
+
+void V2XFrameFromBsm(const V2XBsm& bsm, V2XBsmMask present, V2XBsmFrame& frame)
+{
+  frame.present = present & kBsmAllFields;
+  memset(frame.values, 0, sizeof(frame.values));
+  memset(frame.id, 0, sizeof(frame.id));
+
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    V2XBsmField field = (V2XBsmField)i;
+    if ((frame.present & V2XBsmBit(field))==0)
+    {
+      continue;
+    }
+    const void* p = V2XBsmFieldPtr(bsm, field);
+    if (field==kBsmId)
+    {
+      strncpy(frame.id, (const char*)p, kBsmIdLength);
+    }
+    else if (kBsmFields[i].caplType=='C')
+    {
+      frame.values[i] = (int32_t)strtol((const char*)p, nullptr, 0);
+    }
+    else
+    {
+      memcpy(&frame.values[i], p, sizeof(int32_t));
+    }
+  }
+}
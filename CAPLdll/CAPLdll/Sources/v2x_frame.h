@@ -0,0 +1,64 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_frame.h
+|
+|            Binary wire format of the BSM, an alternative to the JSON
+|            document for the link between the CAPL DLL and the ROS / OBU
+|            bridge. The same layout is implemented by
+|            OBU/V2X_ROS_app/src/v2x_bsm_frame.c and
+|            ROS/v2x_ros_driver/scripts/v2x_frame.py.
+|
+|            Layout of version 1, all values little-endian:
+|
+|              offset  size  content
+|                   0     4  magic "V2XB"
+|                   4     1  version
+|                   5     1  flags, bit 0: keyframe
+|                   6     2  reserved, 0
+|                   8     4  sequence number
+|                  12     8  present mask, bit n: field n is valid
+|                  20   144  fields in V2XBsmField order, int32 each,
+|                            except Id: 8 characters, padded with NUL
+|
+|            Later versions may only append data, so a receiver accepts
+|            any version >= 1 and ignores the bytes it does not know.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "v2x_bsm.h"
+
+
+static const uint8_t  kBsmFrameVersion  = 1;
+static const uint8_t  kBsmFrameKeyframe = 0x01;   // flags
+static const size_t   kBsmFrameSize     = 164;
+static const size_t   kBsmIdLength      = 8;
+
+
+// ============================================================================
+// V2XBsmFrame
+//
+// Decoded form of a frame. values[kBsmId] is not used, the id is kept as
+// text in 'id' (not NUL terminated if all 8 characters are used).
+// ============================================================================
+struct V2XBsmFrame
+{
+  uint32_t   seq;
+  uint8_t    flags;
+  V2XBsmMask present;
+  int32_t    values[kBsmFieldCount];
+  char       id[kBsmIdLength];
+};
+
+// Writes 'frame' into 'buffer', returns kBsmFrameSize or 0 if the buffer
+// is too small
+size_t V2XEncodeFrame(const V2XBsmFrame& frame, void* buffer, size_t size);
+
+// Reads a frame, returns false if 'data' is no BSM frame
+bool   V2XDecodeFrame(const void* data, size_t length, V2XBsmFrame& frame);
+
+// Fills the values of 'frame' from the fields 'present' of 'bsm'. Text
+// fields other than the id are sent as the number they contain.
+void   V2XFrameFromBsm(const V2XBsm& bsm, V2XBsmMask present, V2XBsmFrame& frame);
@@ -0,0 +1,164 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_handle_table.h
+|
+|            Lock-free table from CAPL handles to per-instance objects of
+|            the CAPL DLL. Lookups never block; insertions and removals
+|            (dllInit, dllEnd, VIARegisterCDLL) are rare and use CAS on the
+|            slot, so they never block lookups either.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// ============================================================================
+// V2XHandleTable
+//
+// Open addressing over N slots (N a power of two), probing linearly from
+// handle % N. A removed slot becomes a tombstone, which a later Insert
+// reuses, so a lookup only stops at a never-used slot.
+//
+// The table does not own the objects. An object returned by Find stays
+// valid until its owner removes and deletes it, which the DLL only does
+// in dllEnd and ClearAll, i.e. when CAPL no longer uses the handle.
+// ============================================================================
+template <typename T, size_t N = 64>
+class V2XHandleTable
+{
+public:
+  V2XHandleTable()
+  {
+    for (size_t i=0; i<N; ++i)
+    {
+      mHandles[i].store(kFree, std::memory_order_relaxed);
+      mObjects[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // Object of 'handle', nullptr if there is none
+  T* Find(uint32_t handle) const
+  {
+    for (size_t n=0, i=handle & (N-1); n<N; ++n, i=(i+1) & (N-1))
+    {
+      uint32_t h = mHandles[i].load(std::memory_order_acquire);
+      if (h==handle)
+      {
+        return mObjects[i].load(std::memory_order_acquire);
+      }
+      if (h==kFree)
+      {
+        break;
+      }
+    }
+    return nullptr;
+  }
+
+  // Adds or replaces the object of 'handle', returns false if the table is full
+  bool Insert(uint32_t handle, T* object)
+  {
+    if (handle==kFree || handle==kRemoved || handle==kBusy)
+    {
+      return false;
+    }
+    for (size_t n=0, i=handle & (N-1); n<N; ++n, i=(i+1) & (N-1))
+    {
+      uint32_t h = mHandles[i].load(std::memory_order_acquire);
+      if (h==handle)
+      {
+        mObjects[i].store(object, std::memory_order_release);
+        return true;
+      }
+      if (h==kFree)
+      {
+        break;
+      }
+    }
+    for (size_t n=0, i=handle & (N-1); n<N; ++n, i=(i+1) & (N-1))
+    {
+      uint32_t h = mHandles[i].load(std::memory_order_acquire);
+      if ((h==kFree || h==kRemoved) && mHandles[i].compare_exchange_strong(h, kBusy))
+      {
+        // publish the object before the handle becomes visible
+        mObjects[i].store(object, std::memory_order_relaxed);
+        mHandles[i].store(handle, std::memory_order_release);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Removes 'handle' and returns its object, nullptr if there was none
+  T* Remove(uint32_t handle)
+  {
+    for (size_t n=0, i=handle & (N-1); n<N; ++n, i=(i+1) & (N-1))
+    {
+      uint32_t h = mHandles[i].load(std::memory_order_acquire);
+      if (h==handle && mHandles[i].compare_exchange_strong(h, kRemoved))
+      {
+        return mObjects[i].exchange(nullptr, std::memory_order_acq_rel);
+      }
+      if (h==kFree)
+      {
+        break;
+      }
+    }
+    return nullptr;
+  }
+
+  // Object in slot 'slot' (0..N-1) and its handle, nullptr for an unused
+  // slot. Used to visit all objects.
+  T* At(size_t slot, uint32_t* handle) const
+  {
+    uint32_t h = mHandles[slot].load(std::memory_order_acquire);
+    if (h==kFree || h==kRemoved || h==kBusy)
+    {
+      return nullptr;
+    }
+    if (handle!=nullptr)
+    {
+      *handle = h;
+    }
+    return mObjects[slot].load(std::memory_order_acquire);
+  }
+
+  // Any object of the table, nullptr if it is empty
+  T* First(uint32_t* handle = nullptr) const
+  {
+    for (size_t i=0; i<N; ++i)
+    {
+      T* object = At(i, handle);
+      if (object!=nullptr)
+      {
+        return object;
+      }
+    }
+    return nullptr;
+  }
+
+  // Removes all handles, only while no other thread uses the table
+  void Clear()
+  {
+    for (size_t i=0; i<N; ++i)
+    {
+      mObjects[i].store(nullptr, std::memory_order_relaxed);
+      mHandles[i].store(kFree, std::memory_order_release);
+    }
+  }
+
+  static const size_t kSize = N;
+
+private:
+  V2XHandleTable(const V2XHandleTable&);             // not copyable
+  V2XHandleTable& operator=(const V2XHandleTable&);
+
+  // Reserved handle values of a slot
+  static const uint32_t kFree    = 0xffffffffu;  // never used
+  static const uint32_t kRemoved = 0xfffffffeu;  // tombstone
+  static const uint32_t kBusy    = 0xfffffffdu;  // Insert in progress
+
+  std::atomic<uint32_t> mHandles[N];
+  std::atomic<T*>       mObjects[N];
+};
@@ -0,0 +1,664 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_json.cpp
+|
+|            Minimal JSON support of the CAPL DLL.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_json.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// "\"key\":" of every field, indexed by V2XBsmField
+struct V2XQuotedKey
+{
+  const char* text;
+  size_t      length;
+};
+
+static const V2XQuotedKey kQuotedKeys[kBsmFieldCount] =
+{
+#define V2X_BSM_QUOTED_KEY(field, member, type, key, scale, event, setName, getName, text) \
+  { "\"" key "\":", sizeof("\"" key "\":") - 1 },
+  V2X_BSM_FIELDS(V2X_BSM_QUOTED_KEY)
+#undef V2X_BSM_QUOTED_KEY
+};
+
+// Two digit pairs "00".."99" for the integer formatting
+static const char kDigitPairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+
+V2XJsonWriter::V2XJsonWriter(char* buffer, size_t size)
+ : mBuffer(buffer),
+   mSize(size),
+   mPos(0),
+   mOverflow(false),
+   mFirst(true)
+{
+}
+
+void V2XJsonWriter::Put(char c)
+{
+  if (mPos>=mSize)
+  {
+    mOverflow = true;
+    return;
+  }
+  mBuffer[mPos++] = c;
+}
+
+void V2XJsonWriter::Put(const char* s, size_t n)
+{
+  if (n>mSize-mPos)
+  {
+    mOverflow = true;
+    mPos = mSize;
+    return;
+  }
+  memcpy(mBuffer+mPos, s, n);
+  mPos += n;
+}
+
+void V2XJsonWriter::Separator()
+{
+  if (!mFirst)
+  {
+    Put(',');
+  }
+  mFirst = false;
+}
+
+void V2XJsonWriter::BeginObject()
+{
+  Put('{');
+  mFirst = true;
+}
+
+void V2XJsonWriter::EndObject()
+{
+  Put('}');
+  mFirst = false;
+}
+
+void V2XJsonWriter::Key(const char* key)
+{
+  Separator();
+  Put('"');
+  Put(key, strlen(key));
+  Put("\":", 2);
+}
+
+void V2XJsonWriter::QuotedKey(const char* quotedKey, size_t length)
+{
+  Separator();
+  Put(quotedKey, length);
+}
+
+void V2XJsonWriter::Int(int64_t value)
+{
+  // digits are produced backwards, two at a time
+  char     digits[24];
+  char*    p = digits + sizeof(digits);
+  uint64_t u = value<0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+  while (u>=100)
+  {
+    uint32_t pair = (uint32_t)(u % 100) * 2;
+    u /= 100;
+    *--p = kDigitPairs[pair+1];
+    *--p = kDigitPairs[pair];
+  }
+  if (u>=10)
+  {
+    *--p = kDigitPairs[u*2+1];
+    *--p = kDigitPairs[u*2];
+  }
+  else
+  {
+    *--p = (char)('0' + u);
+  }
+  if (value<0)
+  {
+    *--p = '-';
+  }
+  Put(p, digits + sizeof(digits) - p);
+}
+
+void V2XJsonWriter::String(const char* value)
+{
+  Put('"');
+  const char* run = value;
+  for (const char* s=value; *s!=0; ++s)
+  {
+    unsigned char c = (unsigned char)*s;
+    if (c>=0x20 && c!='"' && c!='\\')
+    {
+      continue;
+    }
+    Put(run, s - run);
+    run = s + 1;
+    switch (c)
+    {
+    case '"':  Put("\\\"", 2); break;
+    case '\\': Put("\\\\", 2); break;
+    case '\n': Put("\\n", 2);  break;
+    case '\r': Put("\\r", 2);  break;
+    case '\t': Put("\\t", 2);  break;
+    default:
+      {
+        char escape[6] = { '\\', 'u', '0', '0', kHexDigits[c >> 4], kHexDigits[c & 0x0f] };
+        Put(escape, sizeof(escape));
+      }
+      break;
+    }
+  }
+  Put(run, strlen(run));
+  Put('"');
+}
+
+
+void V2XWriteBsm(V2XJsonWriter& writer, const V2XBsm& bsm, V2XBsmMask fields)
+{
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    V2XBsmField field = (V2XBsmField)i;
+    if ((fields & V2XBsmBit(field))==0)
+    {
+      continue;
+    }
+    writer.QuotedKey(kQuotedKeys[i].text, kQuotedKeys[i].length);
+    const void* p = V2XBsmFieldPtr(bsm, field);
+    if (kBsmFields[i].caplType=='C')
+    {
+      writer.String((const char*)p);
+    }
+    else
+    {
+      int32_t value;
+      memcpy(&value, p, sizeof(value));
+      writer.Int(value);
+    }
+  }
+}
+
+
+// ============================================================================
+// Key lookup
+//
+// FNV-1a with a seed that maps the keys of V2X_BSM_FIELDS onto distinct
+// slots of a 64 entry table, so a lookup is one hash and one compare. The
+// table is filled from kBsmFields when the DLL is loaded; should a new key
+// collide it takes the next free slot and is still found.
+// ============================================================================
+static const uint32_t kKeyHashSeed  = 0x328f7;
+static const size_t   kKeySlotCount = 64;
+static const size_t   kMaxKeyLength = 31;
+
+static_assert(kBsmFieldCount<kKeySlotCount, "key table too small");
+
+static uint32_t sHashKey(const char* key, size_t length)
+{
+  uint32_t h = kKeyHashSeed;
+  for (size_t i=0; i<length; ++i)
+  {
+    h = (h ^ (uint8_t)key[i]) * 0x01000193u;
+  }
+  return h ^ (h >> 15);
+}
+
+class V2XKeyTable
+{
+public:
+  V2XKeyTable()
+  {
+    for (size_t i=0; i<kKeySlotCount; ++i)
+    {
+      mSlots[i] = -1;
+    }
+    for (int32_t i=0; i<kBsmFieldCount; ++i)
+    {
+      const char* key = kBsmFields[i].key;
+      size_t slot = sHashKey(key, strlen(key)) & (kKeySlotCount-1);
+      while (mSlots[slot]>=0)
+      {
+        slot = (slot+1) & (kKeySlotCount-1);
+      }
+      mSlots[slot] = (int8_t)i;
+    }
+  }
+
+  // Field of a key, -1 if the key is unknown
+  int32_t Find(const char* key, size_t length) const
+  {
+    size_t slot = sHashKey(key, length) & (kKeySlotCount-1);
+    for (; mSlots[slot]>=0; slot = (slot+1) & (kKeySlotCount-1))
+    {
+      const char* candidate = kBsmFields[mSlots[slot]].key;
+      if (strncmp(candidate, key, length)==0 && candidate[length]==0)
+      {
+        return mSlots[slot];
+      }
+    }
+    return -1;
+  }
+
+private:
+  int8_t mSlots[kKeySlotCount];
+};
+
+static const V2XKeyTable sKeyTable;
+
+
+// ============================================================================
+// V2XJsonReader
+//
+// Cursor over the received bytes, never reads past 'end'.
+// ============================================================================
+// Nesting limit of skipped values
+static const int32_t kMaxDepth = 16;
+
+class V2XJsonReader
+{
+public:
+  V2XJsonReader(const char* data, size_t length) : mPos(data), mEnd(data+length) {}
+
+  bool ParseObject(V2XBsm& bsm, V2XBsmMask& present);
+
+private:
+  void SkipSpace();
+  bool Expect(char c);
+  bool ReadString(char* out, size_t size, size_t* length);
+  bool ReadNumber(int64_t& value);
+  bool ReadLiteral(const char* literal);
+  bool ReadInt(int32_t& value, bool& isNull);
+  bool ReadText(char* out, size_t size, bool& isNull);
+  bool SkipValue(int32_t depth);
+
+  const char* mPos;
+  const char* mEnd;
+};
+
+void V2XJsonReader::SkipSpace()
+{
+  while (mPos<mEnd && (*mPos==' ' || *mPos=='\t' || *mPos=='\n' || *mPos=='\r'))
+  {
+    ++mPos;
+  }
+}
+
+bool V2XJsonReader::Expect(char c)
+{
+  SkipSpace();
+  if (mPos<mEnd && *mPos==c)
+  {
+    ++mPos;
+    return true;
+  }
+  return false;
+}
+
+bool V2XJsonReader::ReadLiteral(const char* literal)
+{
+  size_t n = strlen(literal);
+  if ((size_t)(mEnd-mPos)<n || memcmp(mPos, literal, n)!=0)
+  {
+    return false;
+  }
+  mPos += n;
+  return true;
+}
+
+// Reads a string, the cursor is at the opening quote. Up to size-1 bytes are
+// stored NUL terminated in 'out' (may be null), the rest is consumed.
+// 'length' receives the full decoded length.
+bool V2XJsonReader::ReadString(char* out, size_t size, size_t* length)
+{
+  if (!Expect('"'))
+  {
+    return false;
+  }
+  size_t n = 0;
+  while (mPos<mEnd)
+  {
+    char    c = *mPos++;
+    char    utf8[3];
+    size_t  count = 1;
+    utf8[0] = c;
+
+    if (c=='"')
+    {
+      if (out!=nullptr && size>0)
+      {
+        out[n<size ? n : size-1] = 0;
+      }
+      if (length!=nullptr)
+      {
+        *length = n;
+      }
+      return true;
+    }
+    if ((unsigned char)c<0x20)
+    {
+      return false;
+    }
+    if (c=='\\')
+    {
+      if (mPos>=mEnd)
+      {
+        return false;
+      }
+      switch (*mPos++)
+      {
+      case '"':  utf8[0] = '"';  break;
+      case '\\': utf8[0] = '\\'; break;
+      case '/':  utf8[0] = '/';  break;
+      case 'b':  utf8[0] = '\b'; break;
+      case 'f':  utf8[0] = '\f'; break;
+      case 'n':  utf8[0] = '\n'; break;
+      case 'r':  utf8[0] = '\r'; break;
+      case 't':  utf8[0] = '\t'; break;
+      case 'u':
+        {
+          if (mEnd-mPos<4)
+          {
+            return false;
+          }
+          uint32_t code = 0;
+          for (int32_t i=0; i<4; ++i)
+          {
+            char h = *mPos++;
+            code <<= 4;
+            if      (h>='0' && h<='9') code |= h - '0';
+            else if (h>='a' && h<='f') code |= h - 'a' + 10;
+            else if (h>='A' && h<='F') code |= h - 'A' + 10;
+            else return false;
+          }
+          // surrogate pairs are kept as two separate code units
+          if (code<0x80)
+          {
+            utf8[0] = (char)code;
+          }
+          else if (code<0x800)
+          {
+            utf8[0] = (char)(0xc0 | (code >> 6));
+            utf8[1] = (char)(0x80 | (code & 0x3f));
+            count = 2;
+          }
+          else
+          {
+            utf8[0] = (char)(0xe0 | (code >> 12));
+            utf8[1] = (char)(0x80 | ((code >> 6) & 0x3f));
+            utf8[2] = (char)(0x80 | (code & 0x3f));
+            count = 3;
+          }
+        }
+        break;
+      default:
+        return false;
+      }
+    }
+    for (size_t i=0; i<count; ++i, ++n)
+    {
+      if (out!=nullptr && n+1<size)
+      {
+        out[n] = utf8[i];
+      }
+    }
+  }
+  return false;
+}
+
+// Reads a number. Fractions and exponents are truncated toward zero, values
+// beyond int64 are clamped.
+bool V2XJsonReader::ReadNumber(int64_t& value)
+{
+  const char* start = mPos;
+  bool negative = mPos<mEnd && *mPos=='-';
+  if (negative)
+  {
+    ++mPos;
+  }
+  if (mPos>=mEnd || *mPos<'0' || *mPos>'9')
+  {
+    return false;
+  }
+  uint64_t u = 0;
+  bool     clamped = false;
+  while (mPos<mEnd && *mPos>='0' && *mPos<='9')
+  {
+    if (u>(uint64_t)INT64_MAX/10)
+    {
+      clamped = true;
+    }
+    else
+    {
+      u = u*10 + (*mPos - '0');
+    }
+    ++mPos;
+  }
+
+  if (mPos<mEnd && (*mPos=='.' || *mPos=='e' || *mPos=='E'))
+  {
+    // rare, let strtod do the work on a bounded copy
+    while (mPos<mEnd && ((*mPos>='0' && *mPos<='9') || *mPos=='.' || *mPos=='e' || *mPos=='E' || *mPos=='+' || *mPos=='-'))
+    {
+      ++mPos;
+    }
+    char text[64];
+    size_t n = mPos - start;
+    if (n>=sizeof(text))
+    {
+      return false;
+    }
+    memcpy(text, start, n);
+    text[n] = 0;
+    double d = strtod(text, nullptr);
+    if      (d>= 9.2e18) value = INT64_MAX;
+    else if (d<=-9.2e18) value = INT64_MIN;
+    else                 value = (int64_t)d;
+    return true;
+  }
+
+  if (clamped || u>(uint64_t)INT64_MAX)
+  {
+    value = negative ? INT64_MIN : INT64_MAX;
+  }
+  else
+  {
+    value = negative ? -(int64_t)u : (int64_t)u;
+  }
+  return true;
+}
+
+// Value of an Int field. Strings are converted with strtol so "0x10" works.
+bool V2XJsonReader::ReadInt(int32_t& value, bool& isNull)
+{
+  SkipSpace();
+  isNull = false;
+  if (mPos>=mEnd)
+  {
+    return false;
+  }
+  switch (*mPos)
+  {
+  case '"':
+    {
+      char text[kBsmTextLength];
+      if (!ReadString(text, sizeof(text), nullptr))
+      {
+        return false;
+      }
+      value = (int32_t)strtol(text, nullptr, 0);
+      return true;
+    }
+  case 't':
+    value = 1;
+    return ReadLiteral("true");
+  case 'f':
+    value = 0;
+    return ReadLiteral("false");
+  case 'n':
+    isNull = true;
+    return ReadLiteral("null");
+  default:
+    {
+      int64_t number;
+      if (!ReadNumber(number))
+      {
+        return false;
+      }
+      value = (int32_t)number;
+      return true;
+    }
+  }
+}
+
+// Value of a Text field. Numbers and booleans are stored as decimal text.
+bool V2XJsonReader::ReadText(char* out, size_t size, bool& isNull)
+{
+  SkipSpace();
+  if (mPos<mEnd && *mPos=='"')
+  {
+    isNull = false;
+    return ReadString(out, size, nullptr);
+  }
+  int32_t value;
+  if (!ReadInt(value, isNull))
+  {
+    return false;
+  }
+  if (!isNull)
+  {
+    snprintf(out, size, "%d", value);
+  }
+  return true;
+}
+
+bool V2XJsonReader::SkipValue(int32_t depth)
+{
+  SkipSpace();
+  if (mPos>=mEnd || depth>kMaxDepth)
+  {
+    return false;
+  }
+  switch (*mPos)
+  {
+  case '"':
+    return ReadString(nullptr, 0, nullptr);
+  case '{':
+  case '[':
+    {
+      char close = *mPos=='{' ? '}' : ']';
+      bool object = close=='}';
+      ++mPos;
+      if (Expect(close))
+      {
+        return true;
+      }
+      do
+      {
+        if (object && (!ReadString(nullptr, 0, nullptr) || !Expect(':')))
+        {
+          return false;
+        }
+        if (!SkipValue(depth+1))
+        {
+          return false;
+        }
+      } while (Expect(','));
+      return Expect(close);
+    }
+  case 't':
+    return ReadLiteral("true");
+  case 'f':
+    return ReadLiteral("false");
+  case 'n':
+    return ReadLiteral("null");
+  default:
+    {
+      int64_t number;
+      return ReadNumber(number);
+    }
+  }
+}
+
+bool V2XJsonReader::ParseObject(V2XBsm& bsm, V2XBsmMask& present)
+{
+  present = 0;
+  if (!Expect('{'))
+  {
+    return false;
+  }
+  if (Expect('}'))
+  {
+    return true;
+  }
+  do
+  {
+    char   key[kMaxKeyLength+1];
+    size_t length;
+    if (!ReadString(key, sizeof(key), &length) || !Expect(':'))
+    {
+      return false;
+    }
+    int32_t i = length<=kMaxKeyLength ? sKeyTable.Find(key, length) : -1;
+    if (i<0)
+    {
+      if (!SkipValue(0))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    V2XBsmField field = (V2XBsmField)i;
+    void*       p     = V2XBsmFieldPtr(bsm, field);
+    bool        isNull;
+    if (kBsmFields[i].caplType=='C')
+    {
+      if (!ReadText((char*)p, kBsmFields[i].size, isNull))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      int32_t value;
+      if (!ReadInt(value, isNull))
+      {
+        return false;
+      }
+      if (!isNull)
+      {
+        memcpy(p, &value, sizeof(value));
+      }
+    }
+    if (!isNull)
+    {
+      present |= V2XBsmBit(field);
+    }
+  } while (Expect(','));
+  return Expect('}');
+}
+
+
+bool V2XParseBsm(const char* data, size_t length, V2XBsm& bsm, V2XBsmMask& present)
+{
+  V2XJsonReader reader(data, length);
+  return reader.ParseObject(bsm, present);
+}
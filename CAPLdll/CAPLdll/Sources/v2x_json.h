@@ -0,0 +1,82 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_json.h
+|
+|            Minimal JSON support of the CAPL DLL, without allocations:
+|            a streaming writer for the send path and a single-pass BSM
+|            parser for the receive path.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "v2x_bsm.h"
+
+
+// Size of a buffer that holds any BSM document written by V2XWriteBsm plus
+// the keys of the delta protocol
+static const size_t kBsmJsonMaxSize = 2048;
+
+
+// ============================================================================
+// V2XJsonWriter
+//
+// Writes one JSON object into a fixed buffer:
+//
+//   V2XJsonWriter writer(buffer, sizeof(buffer));
+//   writer.BeginObject();
+//   writer.Key("Speed");  writer.Int(123);
+//   writer.EndObject();
+//   send(buffer, writer.Length());
+//
+// If the buffer is too small the writer stops writing and Length() returns
+// 0, so a truncated document is never sent. The output is not terminated.
+// ============================================================================
+class V2XJsonWriter
+{
+public:
+  V2XJsonWriter(char* buffer, size_t size);
+
+  void     BeginObject();
+  void     EndObject();
+
+  // Key of the next member, 'key' is written without escaping
+  void     Key(const char* key);
+  // Key given as precomputed "\"key\":" literal of 'length' characters
+  void     QuotedKey(const char* quotedKey, size_t length);
+
+  void     Int(int64_t value);
+  void     String(const char* value);
+
+  // Length of the document, 0 after an overflow
+  size_t   Length() const { return mOverflow ? 0 : mPos; }
+
+private:
+  void     Put(char c);
+  void     Put(const char* s, size_t n);
+  void     Separator();
+
+  char*    mBuffer;
+  size_t   mSize;
+  size_t   mPos;
+  bool     mOverflow;
+  bool     mFirst;     // no member written into the current object yet
+};
+
+
+// Writes the fields 'fields' of 'bsm' as members of the current object of
+// 'writer'. Text fields become JSON strings, all others numbers.
+void V2XWriteBsm(V2XJsonWriter& writer, const V2XBsm& bsm, V2XBsmMask fields);
+
+
+// Parses the JSON object in data[0, length) into 'bsm' in a single pass,
+// without building a DOM. Keys are looked up in a perfect hash of the
+// V2X_BSM_FIELDS keys, unknown members (e.g. "Seq") are skipped.
+//
+// Numbers, booleans and numeric strings ("0x10") are converted like the
+// CAPL getters expect them, text fields keep the string (truncated to
+// kBsmTextLength - 1 characters). 'present' receives the fields found.
+// Returns false if the data is no complete JSON object, 'bsm' and
+// 'present' may then be partly written.
+bool V2XParseBsm(const char* data, size_t length, V2XBsm& bsm, V2XBsmMask& present);
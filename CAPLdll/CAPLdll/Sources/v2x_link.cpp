@@ -0,0 +1,142 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_link.cpp
+|
+|            Link header of the UDP datagrams and its receiver accounting.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_link.h"
+
+#include <string.h>
+
+#include "v2x_stats.h"
+
+
+static const uint8_t kLinkMagic[4] = { 'V', '2', 'X', 'H' };
+
+
+static void sPut32(uint8_t* p, uint32_t v)
+{
+  p[0] = (uint8_t)(v);
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t sGet32(const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t sBitCount(uint64_t v)
+{
+  uint32_t count = 0;
+  for (; v!=0; v &= v - 1)
+  {
+    ++count;
+  }
+  return count;
+}
+
+
+void V2XPutLinkHeader(void* buffer, const V2XLinkHeader& header)
+{
+  uint8_t* p = (uint8_t*)buffer;
+  memcpy(p, kLinkMagic, sizeof(kLinkMagic));
+  sPut32(p+4,  header.seq);
+  sPut32(p+8,  (uint32_t)header.time);
+  sPut32(p+12, (uint32_t)(header.time >> 32));
+}
+
+size_t V2XGetLinkHeader(const void* data, size_t length, V2XLinkHeader& header)
+{
+  const uint8_t* p = (const uint8_t*)data;
+  if (length<kLinkHeaderSize || memcmp(p, kLinkMagic, sizeof(kLinkMagic))!=0)
+  {
+    return 0;
+  }
+  header.seq  = sGet32(p+4);
+  header.time = (uint64_t)sGet32(p+8) | ((uint64_t)sGet32(p+12) << 32);
+  return kLinkHeaderSize;
+}
+
+
+// ============================================================================
+// V2XLinkMonitor
+// ============================================================================
+
+V2XLinkMonitor::V2XLinkMonitor()
+{
+  Reset();
+}
+
+void V2XLinkMonitor::Reset()
+{
+  mStarted = false;
+  mHighest = 0;
+  mLast    = 0;
+  mWindow  = 0;
+}
+
+void V2XLinkMonitor::Receive(const V2XLinkHeader& header, uint64_t now)
+{
+  if (now>=header.time)
+  {
+    V2XStatRecord(kStatLinkLatency, now - header.time);
+  }
+
+  uint32_t seq      = header.seq;
+  uint32_t previous = mLast;
+  mLast = seq;
+  if (!mStarted)
+  {
+    mStarted = true;
+    mHighest = seq;
+    mWindow  = ~(uint64_t)0;  // nothing before the first datagram is missing
+    return;
+  }
+
+  int32_t distance = (int32_t)(seq - mHighest);
+  if (distance>0)
+  {
+    // the numbers that leave the window and were not received are lost
+    uint64_t lost;
+    if ((uint32_t)distance>=kWindow)
+    {
+      lost     = (kWindow - sBitCount(mWindow)) + (distance - kWindow);
+      mWindow  = 1;
+    }
+    else
+    {
+      lost     = distance - sBitCount(mWindow >> (kWindow - distance));
+      mWindow  = (mWindow << distance) | 1;
+    }
+    mHighest = seq;
+    if (lost>0)
+    {
+      V2XStatAdd(kStatDatagramsLost, lost);
+    }
+    return;
+  }
+
+  uint32_t age = (uint32_t)(-(int64_t)distance);
+  if (age>=kWindow)
+  {
+    if (seq==previous + 1)
+    {
+      // two in a row from before the window: the sender started again
+      mHighest = seq;
+      mWindow  = ~(uint64_t)0;
+    }
+    return; // already counted as lost
+  }
+
+  uint64_t bit = (uint64_t)1 << age;
+  if ((mWindow & bit)!=0)
+  {
+    V2XStatAdd(kStatDatagramsDuplicated, 1);
+    return;
+  }
+  mWindow |= bit;
+  V2XStatAdd(kStatDatagramsReordered, 1);
+}
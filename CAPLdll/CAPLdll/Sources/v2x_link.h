@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_link.h
+|
+|            Link header in front of the UDP datagrams between the CAPL
+|            DLL and the ROS / OBU bridge, and the receiver side accounting
+|            of loss, duplicates, reordering and one-way latency. The same
+|            header is written and read by OBU/V2X_ROS_app/src/v2x_link.c
+|            and ROS/v2x_ros_driver/scripts/v2x_link.py.
+|
+|            Layout, all values little-endian:
+|
+|              offset  size  content
+|                   0     4  magic "V2XH"
+|                   4     4  sequence number, +1 per datagram of the sender
+|                   8     8  monotonic send time in ns
+|                  16        JSON document or binary BSM frame
+|
+|            The header is opt-in on the send side (dllSetLinkHeader, -l of
+|            v2x_ros_send, ~link_header of send_upd_signal.py), so consumers
+|            that expect the bare document keep working. Receivers accept
+|            datagrams without the magic as before. The shared memory ring is not a UDP
+|            hop, it numbers its slots and counts its drops itself.
+|
+|            The send time is only comparable with the receive time if both
+|            ends read the same monotonic clock, i.e. run on the same host.
+|            Across hosts only the spread of the latency is meaningful.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+static const size_t kLinkHeaderSize = 16;
+
+struct V2XLinkHeader
+{
+  uint32_t seq;
+  uint64_t time;           // V2XNowNs() of the sender
+};
+
+// Writes the header into 'buffer' (kLinkHeaderSize bytes)
+void   V2XPutLinkHeader(void* buffer, const V2XLinkHeader& header);
+// Reads the header at the start of 'data', returns its size or 0 if the
+// datagram has none
+size_t V2XGetLinkHeader(const void* data, size_t length, V2XLinkHeader& header);
+
+
+// ============================================================================
+// V2XLinkMonitor
+//
+// Follows the sequence numbers of one sender with a window of the last
+// kWindow numbers:
+//   - lost:       not received before kWindow newer datagrams arrived
+//   - duplicated: received a second time within the window
+//   - reordered:  received after a newer datagram, within the window
+// Two consecutive datagrams from before the window restart the sender.
+// The counts go to the V2XStatCounter counters, the latency to the
+// kStatLinkLatency histogram. Used by one receiver thread, not thread-safe.
+// ============================================================================
+class V2XLinkMonitor
+{
+public:
+  V2XLinkMonitor();
+
+  void Reset();
+  // Accounts the datagram 'header', received at 'now' (V2XNowNs())
+  void Receive(const V2XLinkHeader& header, uint64_t now);
+
+  static const uint32_t kWindow = 64;
+
+private:
+  bool     mStarted;
+  uint32_t mHighest;       // newest sequence number
+  uint32_t mLast;          // sequence number of the previous datagram
+  uint64_t mWindow;        // bit n: mHighest - n was received
+};
@@ -0,0 +1,417 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_receiver.cpp
+|
+|            Background receiver of the CAPL DLL.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_receiver.h"
+
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+
+#include "v2x_frame.h"
+#include "v2x_json.h"
+#include "v2x_link.h"
+#include "v2x_record.h"
+#include "v2x_stats.h"
+
+#if defined(__linux__)
+  #include <sys/epoll.h>
+  #include <sys/eventfd.h>
+#endif
+
+
+// Receive timeout, bounds the time Stop() waits for the thread where it
+// cannot be woken up
+static const uint32_t kReceiveTimeoutMs  = 100;
+static const int32_t  kReceiveBufferSize = 1024;
+// SO_RCVBUF, holds bursts while the thread is not scheduled
+static const int32_t  kDefaultSocketBufferSize = 1024*1024;
+// datagrams taken by one Poll() of WaitForField
+static const int32_t  kMaxPollDatagrams = 256;
+
+
+V2XReceiver::V2XReceiver()
+ : mSocket(V2X_INVALID_SOCKET),
+   mBufferSize(kDefaultSocketBufferSize),
+#if defined(__linux__)
+   mEpoll(-1),
+   mWakeup(-1),
+#endif
+   mRunning(false),
+   mMuted(false),
+   mPolled(false),
+   mSequence(0),
+   mTime(0),
+   mVersion(0),
+   mWaiters(0)
+{
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    mValues[i].store(0);
+    mUpdated[i].store(0);
+  }
+}
+
+V2XReceiver::~V2XReceiver()
+{
+  Stop();
+}
+
+bool V2XReceiver::Start(uint16_t port, bool polled)
+{
+  if (mRunning.load())
+  {
+    return true;
+  }
+
+  if (!V2XSocketStartup())
+  {
+    return false;
+  }
+
+  mSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (mSocket==V2X_INVALID_SOCKET)
+  {
+    V2XSocketCleanup();
+    return false;
+  }
+
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family      = AF_INET;
+  local.sin_port        = htons(port);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  V2XSetBufferSize(mSocket, SO_RCVBUF, mBufferSize);
+  bool ok = bind(mSocket, (const sockaddr*)&local, sizeof(local))==0;
+#if defined(__linux__)
+  ok = ok && V2XSetNonBlocking(mSocket);
+  if (ok && !polled)
+  {
+    mEpoll  = epoll_create1(EPOLL_CLOEXEC);
+    mWakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLIN;
+    event.data.fd = mSocket;
+    ok = mEpoll>=0 && mWakeup>=0 && epoll_ctl(mEpoll, EPOLL_CTL_ADD, mSocket, &event)==0;
+    event.data.fd = mWakeup;
+    ok = ok && epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeup, &event)==0;
+  }
+#else
+  ok = ok && (polled ? V2XSetNonBlocking(mSocket) : V2XSetReceiveTimeout(mSocket, kReceiveTimeoutMs));
+#endif
+  if (!ok)
+  {
+    CloseSocket();
+    return false;
+  }
+
+  mLink.Reset();
+  mPolled = polled;
+  mRunning.store(true);
+  if (!polled)
+  {
+    mThread = std::thread(&V2XReceiver::Run, this);
+  }
+  return true;
+}
+
+void V2XReceiver::Stop()
+{
+  if (!mRunning.exchange(false))
+  {
+    return;
+  }
+#if defined(__linux__)
+  uint64_t one = 1;
+  if (mWakeup>=0 && write(mWakeup, &one, sizeof(one))<0)
+  {
+    // the thread still sees mRunning after the epoll timeout
+  }
+#endif
+  if (mThread.joinable())
+  {
+    mThread.join();
+  }
+  CloseSocket();
+}
+
+void V2XReceiver::SetBufferSize(int32_t bytes)
+{
+  mBufferSize = bytes;
+  if (mSocket!=V2X_INVALID_SOCKET)
+  {
+    V2XSetBufferSize(mSocket, SO_RCVBUF, bytes);
+  }
+}
+
+void V2XReceiver::CloseSocket()
+{
+#if defined(__linux__)
+  if (mEpoll>=0)
+  {
+    close(mEpoll);
+    mEpoll = -1;
+  }
+  if (mWakeup>=0)
+  {
+    close(mWakeup);
+    mWakeup = -1;
+  }
+#endif
+  V2XCloseSocket(mSocket);
+  mSocket = V2X_INVALID_SOCKET;
+  V2XSocketCleanup();
+}
+
+#if defined(__linux__)
+void V2XReceiver::Run()
+{
+  char        buffer[kReceiveBufferSize];
+  epoll_event events[2];
+
+  while (mRunning.load())
+  {
+    int count = epoll_wait(mEpoll, events, 2, kReceiveTimeoutMs);
+    for (int i=0; i<count; ++i)
+    {
+      if (events[i].data.fd!=mSocket)
+      {
+        continue; // wakeup of Stop(), the loop condition ends the thread
+      }
+      // drain the socket, epoll reports it again only for new data
+      int32_t length;
+      while ((length = (int32_t)recv(mSocket, buffer, sizeof(buffer), 0))>0)
+      {
+        Receive(buffer, length);
+      }
+    }
+  }
+}
+#else
+void V2XReceiver::Run()
+{
+  char buffer[kReceiveBufferSize];
+
+  while (mRunning.load())
+  {
+    int32_t length = (int32_t)recv(mSocket, buffer, sizeof(buffer), 0);
+    if (length<=0)
+    {
+      continue; // timeout, check for Stop()
+    }
+    Receive(buffer, length);
+  }
+}
+#endif
+
+int32_t V2XReceiver::Poll(int32_t maxDatagrams)
+{
+  if (!mPolled || !mRunning.load())
+  {
+    return 0;
+  }
+  char    buffer[kReceiveBufferSize];
+  int32_t count = 0;
+  int32_t length;
+  while (count<maxDatagrams && (length = (int32_t)recv(mSocket, buffer, sizeof(buffer), 0))>0)
+  {
+    Receive(buffer, length);
+    ++count;
+  }
+  return count;
+}
+
+void V2XReceiver::Receive(const char* data, int32_t length)
+{
+  V2XStatAdd(kStatDatagramsReceived, 1);
+  V2XStatAdd(kStatBytesReceived, length);
+  V2XRecord(kRecordReceived, data, length);
+  V2XLinkHeader header;
+  if (V2XGetLinkHeader(data, length, header)>0)
+  {
+    mLink.Receive(header, V2XNowNs());
+  }
+  if (!mMuted.load(std::memory_order_relaxed))
+  {
+    Publish(data, length);
+  }
+}
+
+void V2XReceiver::Publish(const char* data, int32_t length)
+{
+  // the link header is accounted in Receive(), a replayed datagram keeps it
+  V2XLinkHeader header;
+  size_t        skip = V2XGetLinkHeader(data, length, header);
+  data   += skip;
+  length -= (int32_t)skip;
+
+  V2XBsmFrame frame;
+  if (V2XDecodeFrame(data, length, frame))
+  {
+    PublishFrame(frame);
+    return;
+  }
+
+  V2XBsm     bsm;
+  V2XBsmMask present;
+  if (!V2XParseBsm(data, length, bsm, present))
+  {
+    V2XStatAdd(kStatParseFailures, 1);
+    return;
+  }
+
+  uint64_t now = V2XNowNs();
+  BeginWrite();
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    V2XBsmField field = (V2XBsmField)i;
+    if ((present & V2XBsmBit(field))==0)
+    {
+      continue; // field not part of this message
+    }
+    const void* p = V2XBsmFieldPtr(bsm, field);
+    int32_t value;
+    if (kBsmFields[i].caplType=='C')
+    {
+      value = (int32_t)strtol((const char*)p, nullptr, 0);
+    }
+    else
+    {
+      memcpy(&value, p, sizeof(value));
+    }
+    mValues[i].store(value, std::memory_order_relaxed);
+    mUpdated[i].store(now, std::memory_order_relaxed);
+  }
+  mTime.store(now, std::memory_order_relaxed);
+  mSequence.fetch_add(1, std::memory_order_release);
+  EndWrite();
+}
+
+void V2XReceiver::PublishFrame(const V2XBsmFrame& frame)
+{
+  uint64_t now = V2XNowNs();
+  BeginWrite();
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    if ((frame.present & V2XBsmBit((V2XBsmField)i))==0)
+    {
+      continue;
+    }
+    int32_t value = frame.values[i];
+    if (i==kBsmId)
+    {
+      char id[kBsmIdLength+1];
+      memcpy(id, frame.id, kBsmIdLength);
+      id[kBsmIdLength] = 0;
+      value = (int32_t)strtol(id, nullptr, 0);
+    }
+    mValues[i].store(value, std::memory_order_relaxed);
+    mUpdated[i].store(now, std::memory_order_relaxed);
+  }
+  mTime.store(now, std::memory_order_relaxed);
+  mSequence.fetch_add(1, std::memory_order_release);
+  EndWrite();
+}
+
+void V2XReceiver::BeginWrite()
+{
+  uint32_t version = mVersion.load(std::memory_order_relaxed);
+  for (;;)
+  {
+    if ((version & 1)==0 &&
+        mVersion.compare_exchange_weak(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed))
+    {
+      break;
+    }
+    version = mVersion.load(std::memory_order_relaxed);
+  }
+  // the stores of the message must not become visible before the odd version
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void V2XReceiver::EndWrite()
+{
+  mVersion.fetch_add(1, std::memory_order_seq_cst);
+  // pairs with the increment of mWaiters in WaitForField, either the
+  // waiter sees the new message or this sees the waiter
+  if (mWaiters.load(std::memory_order_seq_cst)!=0)
+  {
+    std::lock_guard<std::mutex> lock(mWaitMutex);
+    mWaitSignal.notify_all();
+  }
+}
+
+void V2XReceiver::Snapshot(V2XBsmSnapshot& snapshot) const
+{
+  for (;;)
+  {
+    uint32_t before = mVersion.load(std::memory_order_acquire);
+    if ((before & 1)!=0)
+    {
+      continue; // a message is being published
+    }
+    for (int32_t i=0; i<kBsmFieldCount; ++i)
+    {
+      snapshot.values[i] = mValues[i].load(std::memory_order_relaxed);
+    }
+    snapshot.sequence = mSequence.load(std::memory_order_relaxed);
+    snapshot.time     = mTime.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mVersion.load(std::memory_order_relaxed)==before)
+    {
+      return;
+    }
+  }
+}
+
+void V2XReceiver::Field(V2XBsmField field, int32_t& value, uint64_t& time) const
+{
+  for (;;)
+  {
+    uint32_t before = mVersion.load(std::memory_order_acquire);
+    if ((before & 1)!=0)
+    {
+      continue;
+    }
+    value = mValues[field].load(std::memory_order_relaxed);
+    time  = mUpdated[field].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mVersion.load(std::memory_order_relaxed)==before)
+    {
+      return;
+    }
+  }
+}
+
+bool V2XReceiver::WaitForField(V2XBsmField field, uint64_t time, uint32_t timeoutMs)
+{
+  if (mPolled)
+  {
+    Poll(kMaxPollDatagrams);
+    return mUpdated[field].load(std::memory_order_acquire)>time;
+  }
+
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+  std::unique_lock<std::mutex> lock(mWaitMutex);
+  mWaiters.fetch_add(1, std::memory_order_seq_cst);
+  bool updated;
+  bool timedOut = false;
+  for (;;)
+  {
+    // the version load orders the check after the message, see EndWrite
+    mVersion.load(std::memory_order_seq_cst);
+    updated = mUpdated[field].load(std::memory_order_acquire)>time;
+    if (updated || timedOut)
+    {
+      break;
+    }
+    timedOut = mWaitSignal.wait_until(lock, deadline)==std::cv_status::timeout;
+  }
+  mWaiters.fetch_sub(1, std::memory_order_relaxed);
+  return updated;
+}
@@ -0,0 +1,130 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_receiver.h
+|
+|            Background receiver of the CAPL DLL. One thread owns the
+|            receive socket, parses every datagram once and publishes the
+|            fields into a latest-value table read by the Get* exports.
+|            On Linux the socket is non-blocking and the thread waits in
+|            epoll, Stop() wakes it through an eventfd. Elsewhere it blocks
+|            in recv with a timeout.
+|
+|            In the polled mode there is no thread: the owner drains the
+|            non-blocking socket by Poll() from a VIA timer, so datagrams
+|            are taken in the measurement context at points in simulated
+|            time and no call ever blocks the measurement.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "v2x_bsm.h"
+#include "v2x_frame.h"
+#include "v2x_link.h"
+#include "v2x_socket.h"
+
+
+// ============================================================================
+// V2XBsmSnapshot
+//
+// All fields of the receive table as of one message, see
+// V2XReceiver::Snapshot.
+// ============================================================================
+struct V2XBsmSnapshot
+{
+  int32_t  values[kBsmFieldCount];
+  uint32_t sequence;       // V2XReceiver::Sequence() of the message
+  uint64_t time;           // V2XNowNs() when it was published, 0 if none
+};
+
+
+// ============================================================================
+// V2XReceiver
+// ============================================================================
+class V2XReceiver
+{
+public:
+  V2XReceiver();
+  ~V2XReceiver();
+
+  // Binds the receive socket and starts the receiver thread, 'polled'
+  // starts no thread, see Poll()
+  bool     Start(uint16_t port, bool polled = false);
+  // SO_RCVBUF of the socket, applied at once and on the next Start
+  void     SetBufferSize(int32_t bytes);
+  // Stops the receiver thread and closes the socket
+  void     Stop();
+  bool     IsRunning() const { return mRunning.load(); }
+  bool     IsPolled() const  { return mPolled; }
+
+  // Polled mode: receives the datagrams waiting in the socket, at most
+  // 'maxDatagrams', without blocking. Returns the number received. Call
+  // from one thread only (the measurement context).
+  int32_t  Poll(int32_t maxDatagrams);
+
+  // Latest received value of a field (0 until the field was received).
+  // Lock-free, can be called from any thread.
+  int32_t  Get(V2XBsmField field) const { return mValues[field].load(std::memory_order_relaxed); }
+
+  // Number of messages published into the table so far
+  uint32_t Sequence() const { return mSequence.load(std::memory_order_acquire); }
+
+  // Copies the whole table, consistent with one message (seqlock: retries
+  // while a message is being published). Lock-free, any thread.
+  void     Snapshot(V2XBsmSnapshot& snapshot) const;
+  // Latest value of a field and the V2XNowNs() time it was received at,
+  // 0 if never. Consistent like Snapshot().
+  void     Field(V2XBsmField field, int32_t& value, uint64_t& time) const;
+  // Waits up to 'timeoutMs' until 'field' was received after 'time',
+  // returns false on timeout. In the polled mode it polls once instead,
+  // waiting would only block the context that polls.
+  bool     WaitForField(V2XBsmField field, uint64_t time, uint32_t timeoutMs);
+
+  // Publishes a datagram that did not come from the socket (replay)
+  void     Inject(const char* data, int32_t length) { Publish(data, length); }
+  // While muted, datagrams from the socket are still recorded but not
+  // published, so a replay is not mixed with live traffic
+  void     SetMuted(bool muted) { mMuted.store(muted); }
+
+private:
+  V2XReceiver(const V2XReceiver&);             // not copyable
+  V2XReceiver& operator=(const V2XReceiver&);
+
+  void     Run();
+  void     Publish(const char* data, int32_t length);
+  void     PublishFrame(const V2XBsmFrame& frame);
+
+  void     Receive(const char* data, int32_t length);
+  // Seqlock around the stores of one message. Writers are the receiver
+  // thread and Inject() in the measurement context.
+  void     BeginWrite();
+  void     EndWrite();
+  void     CloseSocket();
+
+  V2XSocketHandle       mSocket;
+  int32_t               mBufferSize;
+#if defined(__linux__)
+  int                   mEpoll;
+  int                   mWakeup;          // eventfd, signaled by Stop()
+#endif
+  std::thread           mThread;
+  std::atomic<bool>     mRunning;
+  std::atomic<bool>     mMuted;
+  bool                  mPolled;          // no thread, see Poll()
+  V2XLinkMonitor        mLink;            // receiver thread resp. Poll() only
+
+  std::atomic<int32_t>  mValues[kBsmFieldCount];
+  std::atomic<uint32_t> mSequence;
+  std::atomic<uint64_t> mTime;            // of the last message
+  std::atomic<uint64_t> mUpdated[kBsmFieldCount];
+  std::atomic<uint32_t> mVersion;         // seqlock, odd while publishing
+
+  // WaitForField sleeps here, the publisher takes the mutex only while
+  // mWaiters is not 0
+  std::mutex              mWaitMutex;
+  std::condition_variable mWaitSignal;
+  std::atomic<uint32_t>   mWaiters;
+};
@@ -0,0 +1,405 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_record.cpp
+|
+|            Capture and replay log of the V2X traffic of the CAPL DLL.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_record.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "v2x_stats.h"
+
+#if defined(_WIN32)
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+
+static const uint8_t kRecordMagic[4]    = { 'V', '2', 'X', 'L' };
+static const size_t  kRecordEntrySize   = 16;        // record header before the datagram
+static const size_t  kCaptureBufferSize = 1024*1024; // per buffer, two are used alternately
+static const int     kFlushPeriodMs     = 100;
+
+
+static void sPut32(uint8_t* p, uint32_t v)
+{
+  p[0] = (uint8_t)(v);
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static void sPut64(uint8_t* p, uint64_t v)
+{
+  sPut32(p,   (uint32_t)v);
+  sPut32(p+4, (uint32_t)(v >> 32));
+}
+
+static uint32_t sGet32(const uint8_t* p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t sGet64(const uint8_t* p)
+{
+  return (uint64_t)sGet32(p) | ((uint64_t)sGet32(p+4) << 32);
+}
+
+static size_t sPadded(size_t length)
+{
+  return (length + 7) & ~(size_t)7;
+}
+
+
+// ============================================================================
+// Capture
+//
+// The producers append complete records to the active buffer under
+// sCaptureMutex (a memcpy), the writer thread swaps the buffers and
+// writes the full one to the file.
+// ============================================================================
+static std::atomic<bool>       sCapturing(false);
+static std::mutex              sCaptureMutex;
+static std::condition_variable sCaptureWakeup;
+static std::thread             sCaptureThread;
+static bool                    sStopCapture = false;
+static std::vector<uint8_t>    sBuffers[2];
+static size_t                  sActive      = 0;
+static size_t                  sFill        = 0;
+static uint64_t                sStartTime   = 0;
+static FILE*                   sFile        = nullptr;
+
+static void sCaptureLoop()
+{
+  std::vector<uint8_t> index;
+  uint64_t             offset  = kRecordHeaderSize;
+  uint64_t             records = 0;
+
+  std::unique_lock<std::mutex> lock(sCaptureMutex);
+  for (;;)
+  {
+    bool stop = sStopCapture;
+    if (!stop)
+    {
+      sCaptureWakeup.wait_for(lock, std::chrono::milliseconds(kFlushPeriodMs));
+      stop = sStopCapture;
+    }
+
+    std::vector<uint8_t>& full = sBuffers[sActive];
+    size_t                size = sFill;
+    sActive = 1 - sActive;
+    sFill   = 0;
+    lock.unlock();
+
+    // index every kRecordIndexInterval-th record
+    for (size_t pos=0; pos<size; )
+    {
+      if (records % kRecordIndexInterval==0)
+      {
+        uint8_t entry[16];
+        sPut64(entry,   sGet64(&full[pos]));
+        sPut64(entry+8, offset + pos);
+        index.insert(index.end(), entry, entry+16);
+      }
+      ++records;
+      pos += kRecordEntrySize + sPadded(sGet32(&full[pos+8]));
+    }
+    fwrite(full.data(), 1, size, sFile);
+    offset += size;
+
+    lock.lock();
+    if (stop)
+    {
+      break;
+    }
+  }
+  lock.unlock();
+
+  fwrite(index.data(), 1, index.size(), sFile);
+  uint8_t trailer[16];
+  sPut64(trailer,   index.empty() ? 0 : offset);
+  sPut64(trailer+8, records);
+  fseek(sFile, 16, SEEK_SET);
+  fwrite(trailer, 1, sizeof(trailer), sFile);
+  fclose(sFile);
+  sFile = nullptr;
+}
+
+bool V2XStartCapture(const char* path)
+{
+  V2XStopCapture();
+  if (path==nullptr || path[0]==0)
+  {
+    return false;
+  }
+
+  FILE* file = fopen(path, "wb");
+  if (file==nullptr)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(sCaptureMutex);
+  sBuffers[0].resize(kCaptureBufferSize);
+  sBuffers[1].resize(kCaptureBufferSize);
+  sActive      = 0;
+  sFill        = 0;
+  sStopCapture = false;
+  sStartTime   = V2XNowNs();
+  sFile        = file;
+
+  uint8_t header[kRecordHeaderSize];
+  memset(header, 0, sizeof(header));
+  memcpy(header, kRecordMagic, sizeof(kRecordMagic));
+  sPut32(header+4, kRecordVersion);
+  sPut64(header+8, sStartTime);
+  fwrite(header, 1, sizeof(header), sFile);
+
+  sCaptureThread = std::thread(sCaptureLoop);
+  sCapturing.store(true);
+  return true;
+}
+
+void V2XStopCapture()
+{
+  if (!sCapturing.exchange(false))
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(sCaptureMutex);
+    sStopCapture = true;
+  }
+  sCaptureWakeup.notify_all();
+  if (sCaptureThread.joinable())
+  {
+    sCaptureThread.join();
+  }
+}
+
+bool V2XIsCapturing()
+{
+  return sCapturing.load(std::memory_order_relaxed);
+}
+
+void V2XRecord(V2XRecordDirection direction, const void* data, size_t length)
+{
+  if (!sCapturing.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+
+  size_t need = kRecordEntrySize + sPadded(length);
+  bool   half;
+  {
+    std::lock_guard<std::mutex> lock(sCaptureMutex);
+    if (sFile==nullptr || sFill + need>kCaptureBufferSize)
+    {
+      V2XStatAdd(kStatRecordsDropped, 1);
+      return;
+    }
+    uint8_t* p = &sBuffers[sActive][sFill];
+    sPut64(p, V2XNowNs() - sStartTime);
+    sPut32(p+8, (uint32_t)length);
+    p[12] = (uint8_t)direction;
+    p[13] = 0;
+    p[14] = 0;
+    p[15] = 0;
+    memcpy(p+kRecordEntrySize, data, length);
+    memset(p+kRecordEntrySize+length, 0, sPadded(length) - length);
+    sFill += need;
+    half   = sFill>kCaptureBufferSize/2;
+  }
+  if (half)
+  {
+    sCaptureWakeup.notify_one();
+  }
+}
+
+
+// ============================================================================
+// V2XLogReader
+// ============================================================================
+
+V2XLogReader::V2XLogReader()
+ : mBase(nullptr),
+   mSize(0),
+   mEnd(0),
+   mIndex(0),
+   mPosition(0)
+#if defined(_WIN32)
+   , mFile(nullptr),
+   mMapping(nullptr)
+#endif
+{}
+
+V2XLogReader::~V2XLogReader()
+{
+  Close();
+}
+
+bool V2XLogReader::Open(const char* path)
+{
+  Close();
+  if (path==nullptr)
+  {
+    return false;
+  }
+
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file==INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  LARGE_INTEGER size;
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart>=(LONGLONG)kRecordHeaderSize)
+  {
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+  const void* base = (mapping!=nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (base==nullptr)
+  {
+    if (mapping!=nullptr)
+    {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    return false;
+  }
+  mFile    = file;
+  mMapping = mapping;
+  mSize    = (size_t)size.QuadPart;
+#else
+  int fd = open(path, O_RDONLY);
+  if (fd<0)
+  {
+    return false;
+  }
+  struct stat info;
+  void* base = MAP_FAILED;
+  if (fstat(fd, &info)==0 && (size_t)info.st_size>=kRecordHeaderSize)
+  {
+    base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base==MAP_FAILED)
+  {
+    return false;
+  }
+  mSize = (size_t)info.st_size;
+#endif
+  mBase = (const uint8_t*)base;
+
+  if (memcmp(mBase, kRecordMagic, sizeof(kRecordMagic))!=0 || sGet32(mBase+4)<kRecordVersion)
+  {
+    Close();
+    return false;
+  }
+  uint64_t index = sGet64(mBase+16);
+  mIndex    = (index>=kRecordHeaderSize && index<=mSize) ? (size_t)index : 0;
+  mEnd      = (mIndex!=0) ? mIndex : mSize;
+  mPosition = kRecordHeaderSize;
+  return true;
+}
+
+void V2XLogReader::Close()
+{
+  if (mBase==nullptr)
+  {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(mBase);
+  CloseHandle((HANDLE)mMapping);
+  CloseHandle((HANDLE)mFile);
+  mMapping = nullptr;
+  mFile    = nullptr;
+#else
+  munmap((void*)mBase, mSize);
+#endif
+  mBase = nullptr;
+  mSize = 0;
+}
+
+void V2XLogReader::Seek(uint64_t time)
+{
+  mPosition = kRecordHeaderSize;
+  if (mBase==nullptr)
+  {
+    return;
+  }
+
+  // last index entry before 'time', then linear
+  if (mIndex!=0)
+  {
+    size_t count = (mSize - mIndex) / 16;
+    size_t low   = 0;
+    size_t high  = count;
+    while (low<high)
+    {
+      size_t middle = (low + high) / 2;
+      if (sGet64(mBase + mIndex + middle*16)<time)
+      {
+        low = middle + 1;
+      }
+      else
+      {
+        high = middle;
+      }
+    }
+    if (low>0)
+    {
+      mPosition = (size_t)sGet64(mBase + mIndex + (low-1)*16 + 8);
+    }
+  }
+
+  V2XRecordEntry entry;
+  while (Peek(entry) && entry.time<time)
+  {
+    Next(entry);
+  }
+}
+
+bool V2XLogReader::Peek(V2XRecordEntry& entry) const
+{
+  if (mBase==nullptr || mPosition + kRecordEntrySize>mEnd)
+  {
+    return false;
+  }
+  const uint8_t* p = mBase + mPosition;
+  uint32_t length = sGet32(p+8);
+  if (mPosition + kRecordEntrySize + length>mEnd)
+  {
+    return false; // cut off at the end of an unclosed log
+  }
+  entry.time      = sGet64(p);
+  entry.direction = (V2XRecordDirection)p[12];
+  entry.data      = (const char*)p + kRecordEntrySize;
+  entry.length    = length;
+  return true;
+}
+
+bool V2XLogReader::Next(V2XRecordEntry& entry)
+{
+  if (!Peek(entry))
+  {
+    return false;
+  }
+  mPosition += kRecordEntrySize + sPadded(entry.length);
+  return true;
+}
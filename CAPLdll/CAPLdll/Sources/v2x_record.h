@@ -0,0 +1,105 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_record.h
+|
+|            Capture of the V2X traffic of the CAPL DLL into an append-only
+|            binary log and the reader used for the replay.
+|
+|            Layout of version 1, all values little-endian:
+|
+|              offset  size  content
+|                   0     4  magic "V2XL"
+|                   4     4  version
+|                   8     8  monotonic time of the start in ns
+|                  16     8  offset of the index, 0 if the log was not
+|                            closed (the records are read up to the end)
+|                  24     8  number of records, 0 if not closed
+|                  32        records, each aligned to 8 bytes:
+|                              8  time since the start in ns
+|                              4  length of the datagram
+|                              1  V2XRecordDirection
+|                              3  reserved, 0
+|                              n  datagram, padded with 0 to 8 bytes
+|               index        entries of every kRecordIndexInterval-th
+|                            record: 8 time in ns, 8 offset of the record
+|
+|            The records are written by a background thread, the sending
+|            and receiving threads only copy the datagram into a buffer.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+enum V2XRecordDirection
+{
+  kRecordSent     = 0,
+  kRecordReceived = 1
+};
+
+static const uint32_t kRecordVersion       = 1;
+static const size_t   kRecordHeaderSize    = 32;
+static const uint32_t kRecordIndexInterval = 256;
+
+
+// Starts the capture into 'path' (truncated), returns false if the file
+// cannot be created
+bool V2XStartCapture(const char* path);
+// Writes the remaining records and the index and closes the log
+void V2XStopCapture();
+bool V2XIsCapturing();
+
+// Appends one datagram to the log if the capture runs. Lock-free check,
+// called from the send path and the receiver thread. A datagram that does
+// not fit into the buffer counts as kStatRecordsDropped.
+void V2XRecord(V2XRecordDirection direction, const void* data, size_t length);
+
+
+// One record of a log
+struct V2XRecordEntry
+{
+  uint64_t           time;        // ns since the start of the capture
+  V2XRecordDirection direction;
+  const char*        data;        // points into the mapped log
+  uint32_t           length;
+};
+
+
+// ============================================================================
+// V2XLogReader
+//
+// Maps a log into memory and iterates over its records.
+// ============================================================================
+class V2XLogReader
+{
+public:
+  V2XLogReader();
+  ~V2XLogReader();
+
+  bool Open(const char* path);
+  void Close();
+  bool IsOpen() const { return mBase!=nullptr; }
+
+  // Moves to the first record at or after 'time' (ns since the start),
+  // with the index if the log has one
+  void Seek(uint64_t time);
+  // Reads the record at the current position without moving
+  bool Peek(V2XRecordEntry& entry) const;
+  // Reads the record at the current position and moves to the next one
+  bool Next(V2XRecordEntry& entry);
+
+private:
+  V2XLogReader(const V2XLogReader&);           // not copyable
+  V2XLogReader& operator=(const V2XLogReader&);
+
+  const uint8_t* mBase;
+  size_t         mSize;
+  size_t         mEnd;        // end of the records
+  size_t         mIndex;      // offset of the index, 0 if none
+  size_t         mPosition;
+#if defined(_WIN32)
+  void*          mFile;
+  void*          mMapping;
+#endif
+};
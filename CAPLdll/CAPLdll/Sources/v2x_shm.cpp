@@ -0,0 +1,226 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_shm.cpp
+|
+|            Shared memory transport of the CAPL DLL.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_shm.h"
+
+#include <string.h>
+#include <string>
+
+#if defined(_WIN32)
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+#if defined(__linux__)
+  #include <limits.h>
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+#endif
+
+
+static const uint8_t kShmMagic[4] = { 'V', '2', 'X', 'R' };
+
+
+static uint32_t sRoundUpPow2(uint32_t value)
+{
+  uint32_t result = 2;
+  while (result<value && result<kShmMaxSlots)
+  {
+    result <<= 1;
+  }
+  return result;
+}
+
+
+V2XShmRing::V2XShmRing()
+ : mHeader(nullptr),
+   mSlots(nullptr),
+   mSize(0)
+#if defined(_WIN32)
+   , mMapping(nullptr)
+#endif
+{}
+
+V2XShmRing::~V2XShmRing()
+{
+  Close();
+}
+
+// Slot count of a valid ring of version 1 at 'header', 0 if there is none.
+// 'available' is the size of the region in bytes.
+static uint32_t sLiveSlotCount(const V2XShmHeader* header, size_t available)
+{
+  uint32_t count = header->slotCount;
+  if (memcmp(&header->magic, kShmMagic, sizeof(kShmMagic))!=0 ||
+      header->version!=kShmVersion || header->slotSize!=kShmSlotSize ||
+      count<2 || count>kShmMaxSlots || (count & (count - 1))!=0 ||
+      available<sizeof(V2XShmHeader) + (size_t)count*kShmSlotSize)
+  {
+    return 0;
+  }
+  return count;
+}
+
+bool V2XShmRing::Open(const char* name, uint32_t slots)
+{
+  Close();
+  if (name==nullptr || name[0]==0)
+  {
+    return false;
+  }
+
+  // A ring that already exists keeps its geometry: a reader may be attached
+  // and index its slots with the old count. 'slots' only applies to a new
+  // region, unlink it to change the size.
+  uint32_t count = sRoundUpPow2(slots>0 ? slots : kShmDefaultSlots);
+  size_t   size;
+  void*    base;
+
+#if defined(_WIN32)
+  std::string path = std::string("Local\\") + name;
+  HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                      0, (DWORD)(sizeof(V2XShmHeader) + (size_t)count*kShmSlotSize), path.c_str());
+  if (mapping==nullptr)
+  {
+    return false;
+  }
+  if (GetLastError()==ERROR_ALREADY_EXISTS)
+  {
+    MEMORY_BASIC_INFORMATION info;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view!=nullptr && VirtualQuery(view, &info, sizeof(info))==sizeof(info))
+    {
+      uint32_t live = sLiveSlotCount((const V2XShmHeader*)view, info.RegionSize);
+      count = (live!=0) ? live : count;
+    }
+    if (view!=nullptr)
+    {
+      UnmapViewOfFile(view);
+    }
+  }
+  size = sizeof(V2XShmHeader) + (size_t)count*kShmSlotSize;
+  base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (base==nullptr)
+  {
+    CloseHandle(mapping);
+    return false;
+  }
+  mMapping = mapping;
+#else
+  std::string path = (name[0]=='/') ? std::string(name) : std::string("/") + name;
+  int fd = shm_open(path.c_str(), O_CREAT | O_RDWR, 0666);
+  if (fd<0)
+  {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info)!=0)
+  {
+    close(fd);
+    return false;
+  }
+  if ((size_t)info.st_size>=sizeof(V2XShmHeader))
+  {
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (view!=MAP_FAILED)
+    {
+      uint32_t live = sLiveSlotCount((const V2XShmHeader*)view, info.st_size);
+      count = (live!=0) ? live : count;
+      munmap(view, info.st_size);
+    }
+  }
+  size = sizeof(V2XShmHeader) + (size_t)count*kShmSlotSize;
+  if ((size_t)info.st_size<size && ftruncate(fd, size)!=0)
+  {
+    close(fd);
+    return false;
+  }
+  base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (base==MAP_FAILED)
+  {
+    return false;
+  }
+#endif
+
+  mHeader = (V2XShmHeader*)base;
+  mSlots  = (uint8_t*)base + sizeof(V2XShmHeader);
+  mSize   = size;
+
+  // keep the position of a live ring, so a reader that stays attached
+  // continues with the next frame. Only a region without a valid header is
+  // initialized, readers do not attach before the magic is set.
+  if (sLiveSlotCount(mHeader, size)!=count)
+  {
+    memset((void*)&mHeader->magic, 0, sizeof(mHeader->magic));
+    std::atomic_thread_fence(std::memory_order_release);
+    mHeader->version   = kShmVersion;
+    mHeader->slotSize  = kShmSlotSize;
+    mHeader->slotCount = count;
+    mHeader->dropped.store(0);
+    mHeader->head.store(0);
+    mHeader->waiters.store(0);
+    mHeader->tail.store(0);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&mHeader->magic, kShmMagic, sizeof(kShmMagic));   // valid from now on
+  }
+  return true;
+}
+
+void V2XShmRing::Close()
+{
+  if (mHeader==nullptr)
+  {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(mHeader);
+  CloseHandle((HANDLE)mMapping);
+  mMapping = nullptr;
+#else
+  munmap(mHeader, mSize);
+#endif
+  mHeader = nullptr;
+  mSlots  = nullptr;
+  mSize   = 0;
+}
+
+bool V2XShmRing::Write(const void* data, size_t length)
+{
+  if (mHeader==nullptr || length>kShmSlotSize-8)
+  {
+    return false;
+  }
+
+  uint32_t head = mHeader->head.load(std::memory_order_relaxed);
+  uint32_t tail = mHeader->tail.load(std::memory_order_acquire);
+  if (head - tail>=mHeader->slotCount)
+  {
+    mHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint8_t* slot = mSlots + (size_t)(head & (mHeader->slotCount - 1))*kShmSlotSize;
+  uint32_t size = (uint32_t)length;
+  memcpy(slot,   &head, 4);
+  memcpy(slot+4, &size, 4);
+  memcpy(slot+8, data, length);
+
+  // seq_cst pairs with the reader, which sets 'waiters' before it checks
+  // head a last time and sleeps
+  mHeader->head.store(head + 1, std::memory_order_seq_cst);
+#if defined(__linux__)
+  if (mHeader->waiters.load(std::memory_order_seq_cst)!=0)
+  {
+    syscall(SYS_futex, (uint32_t*)&mHeader->head, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+  }
+#endif
+  return true;
+}
@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_shm.h
+|
+|            Shared memory transport of the CAPL DLL for a bridge on the
+|            same host: a named region holding a single producer / single
+|            consumer ring of binary BSM frames (see v2x_frame.h). The
+|            reader side is OBU/V2X_ROS_app/src/v2x_shm_ring.c and
+|            ROS/v2x_ros_driver/scripts/v2x_shm_ring.py.
+|
+|            Layout of version 1, all values little-endian uint32:
+|
+|              offset  content
+|                   0  magic "V2XR"
+|                   4  version
+|                   8  slot size in bytes
+|                  12  slot count, a power of two
+|                  16  frames dropped by the writer because the ring was full
+|                  64  head: number of frames written, futex word
+|                  68  waiters: not 0 while a reader sleeps on head
+|                 128  tail: number of frames read
+|                 256  slots, slot n at 256 + (n & (count-1)) * slot size:
+|                        0  sequence number, the head the slot was written at
+|                        4  length of the frame
+|                        8  frame
+|
+|            The writer never blocks, a full ring drops the new frame. A
+|            reader may sleep in FUTEX_WAIT on head, the writer wakes it
+|            when 'waiters' is set (Linux only, both readers of this
+|            repository run on Linux).
+|            The region is created by the writer and kept after Close(), a
+|            reopened writer continues at the old head. The geometry of an
+|            existing ring is never changed, a reader may be attached.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+
+static const uint32_t kShmVersion      = 1;
+static const uint32_t kShmSlotSize     = 192;      // 8 bytes slot header + kBsmFrameSize, cache line multiple
+static const uint32_t kShmDefaultSlots = 1024;
+static const uint32_t kShmMaxSlots     = 65536;
+
+
+// ============================================================================
+// V2XShmHeader
+// ============================================================================
+struct V2XShmHeader
+{
+  uint32_t              magic;
+  uint32_t              version;
+  uint32_t              slotSize;
+  uint32_t              slotCount;
+  std::atomic<uint32_t> dropped;
+  uint8_t               pad0[64 - 20];
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> waiters;
+  uint8_t               pad1[64 - 8];
+  std::atomic<uint32_t> tail;
+  uint8_t               pad2[128 - 4];
+};
+
+static_assert(sizeof(V2XShmHeader)==256, "layout of version 1 changed");
+
+
+// ============================================================================
+// V2XShmRing
+//
+// Writer side of the ring, used by one CAPL block (single producer).
+// ============================================================================
+class V2XShmRing
+{
+public:
+  V2XShmRing();
+  ~V2XShmRing();
+
+  // Creates the region 'name' with 'slots' slots (rounded up to a power of
+  // two) or attaches an existing ring with its own slot count
+  bool     Open(const char* name, uint32_t slots);
+  void     Close();
+  bool     IsOpen() const { return mHeader!=nullptr; }
+
+  // Appends one frame, returns false if it is too large or the ring is full
+  bool     Write(const void* data, size_t length);
+
+  uint32_t Dropped() const { return (mHeader!=nullptr) ? mHeader->dropped.load(std::memory_order_relaxed) : 0; }
+
+private:
+  V2XShmRing(const V2XShmRing&);               // not copyable
+  V2XShmRing& operator=(const V2XShmRing&);
+
+  V2XShmHeader* mHeader;
+  uint8_t*      mSlots;
+  size_t        mSize;
+#if defined(_WIN32)
+  void*         mMapping;
+#endif
+};
@@ -0,0 +1,249 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_signal_map.cpp
+|
+|            Mapping of bus signals onto BSM fields.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_signal_map.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+static bool sFieldByKey(const char* key, V2XBsmField& field)
+{
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    if (strcmp(kBsmFields[i].key, key)==0)
+    {
+      field = (V2XBsmField)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static std::string sSignalKey(uint32_t messageId, const char* name)
+{
+  char id[16];
+  snprintf(id, sizeof(id), "%u ", messageId);
+  return std::string(id) + name;
+}
+
+
+V2XSignalMap::V2XSignalMap()
+{}
+
+void V2XSignalMap::Clear()
+{
+  mSignals.clear();
+}
+
+int32_t V2XSignalMap::Load(const char* path, std::string& error)
+{
+  Clear();
+  error.clear();
+
+  std::ifstream file(path!=nullptr ? path : "");
+  if (!file)
+  {
+    error = "cannot open the DBC";
+    return -1;
+  }
+
+  // all signals of the DBC and the V2X attributes, by "id name"
+  std::map<std::string, Signal> signals;
+  std::map<std::string, std::string> fieldKeys;
+  std::map<std::string, double>      factors;
+
+  std::string line;
+  uint32_t    messageId = 0;
+  while (std::getline(file, line))
+  {
+    const char* p = line.c_str();
+    while (*p==' ' || *p=='\t')
+    {
+      ++p;
+    }
+
+    char     name[128];
+    char     key[64];
+    uint32_t id;
+    double   number;
+    if (strncmp(p, "BO_ ", 4)==0)
+    {
+      if (sscanf(p, "BO_ %u", &id)==1)
+      {
+        messageId = id;
+      }
+    }
+    else if (strncmp(p, "SG_ ", 4)==0)
+    {
+      // SG_ <name> [<multiplexer>] : <start>|<length>@<order><sign> (<factor>,<offset>) ...
+      const char* colon = strchr(p, ':');
+      char        mux[16] = "";
+      unsigned    start, length;
+      char        order, sign;
+      double      factor, offset;
+      if (colon==nullptr || sscanf(p, "SG_ %127s %15s", name, mux)<1 ||
+          sscanf(colon+1, " %u|%u@%c%c (%lf,%lf)", &start, &length, &order, &sign, &factor, &offset)!=6)
+      {
+        continue;
+      }
+      if (mux[0]=='m')
+      {
+        continue; // multiplexed signals are not supported
+      }
+      Signal signal;
+      signal.messageId = messageId;
+      signal.startBit  = (uint16_t)start;
+      signal.bitLength = (uint16_t)length;
+      signal.motorola  = order=='0';
+      signal.isSigned  = sign=='-';
+      signal.factor    = factor;
+      signal.offset    = offset;
+      signal.field     = kBsmFieldCount;
+      signals[sSignalKey(messageId, name)] = signal;
+    }
+    else if (sscanf(p, "BA_ \"V2XField\" SG_ %u %127s \"%63[^\"]\"", &id, name, key)==3)
+    {
+      fieldKeys[sSignalKey(id, name)] = key;
+    }
+    else if (sscanf(p, "BA_ \"V2XFactor\" SG_ %u %127s %lf", &id, name, &number)==3)
+    {
+      factors[sSignalKey(id, name)] = number;
+    }
+  }
+
+  for (std::map<std::string, std::string>::const_iterator it=fieldKeys.begin(); it!=fieldKeys.end(); ++it)
+  {
+    std::map<std::string, Signal>::const_iterator signal = signals.find(it->first);
+    V2XBsmField field;
+    if (signal==signals.end() || !sFieldByKey(it->second.c_str(), field) || field==kBsmId ||
+        signal->second.bitLength==0 || signal->second.bitLength>64)
+    {
+      if (error.empty())
+      {
+        // the vehicle id selects the vehicle, it is not a signal value
+        error = "cannot map signal " + it->first + " to " + it->second;
+      }
+      continue;
+    }
+
+    std::map<std::string, double>::const_iterator factor = factors.find(it->first);
+    double scale = ((factor!=factors.end()) ? factor->second : 1.0) / kBsmFields[field].scale;
+
+    Signal mapped  = signal->second;
+    mapped.field   = field;
+    mapped.factor *= scale;
+    mapped.offset *= scale;
+    mSignals.push_back(mapped);
+  }
+
+  struct ById
+  {
+    bool operator()(const Signal& a, const Signal& b) const { return a.messageId<b.messageId; }
+  };
+  std::stable_sort(mSignals.begin(), mSignals.end(), ById());
+  return (int32_t)mSignals.size();
+}
+
+size_t V2XSignalMap::Find(uint32_t id) const
+{
+  size_t low  = 0;
+  size_t high = mSignals.size();
+  while (low<high)
+  {
+    size_t middle = (low + high) / 2;
+    if (mSignals[middle].messageId<id)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Raw value of 'signal' in 'data', false if the frame is too short
+static bool sRawValue(uint16_t startBit, uint16_t bitLength, bool motorola, const uint8_t* data, size_t length, uint64_t& raw)
+{
+  raw = 0;
+  if (!motorola)
+  {
+    if ((size_t)startBit + bitLength>length*8)
+    {
+      return false;
+    }
+    for (uint32_t i=0; i<bitLength; ++i)
+    {
+      uint32_t bit = startBit + i;
+      raw |= (uint64_t)((data[bit/8] >> (bit%8)) & 1) << i;
+    }
+    return true;
+  }
+
+  // Motorola: the start bit is the MSB, the bits run down within a byte
+  // and continue at bit 7 of the next byte
+  uint32_t bit = startBit;
+  for (uint32_t i=0; i<bitLength; ++i)
+  {
+    if (bit/8>=length)
+    {
+      return false;
+    }
+    raw = (raw << 1) | ((data[bit/8] >> (bit%8)) & 1);
+    bit = (bit%8==0) ? bit + 15 : bit - 1;
+  }
+  return true;
+}
+
+V2XBsmMask V2XSignalMap::Decode(uint32_t id, const uint8_t* data, size_t length, V2XBsm& bsm) const
+{
+  V2XBsmMask written = 0;
+  if (data==nullptr)
+  {
+    return written;
+  }
+
+  for (size_t i=Find(id); i<mSignals.size() && mSignals[i].messageId==id; ++i)
+  {
+    const Signal& signal = mSignals[i];
+    uint64_t raw;
+    if (!sRawValue(signal.startBit, signal.bitLength, signal.motorola, data, length, raw))
+    {
+      continue;
+    }
+
+    double value;
+    if (signal.isSigned && signal.bitLength<64 && (raw >> (signal.bitLength-1))!=0)
+    {
+      value = (double)(int64_t)(raw | (~(uint64_t)0 << signal.bitLength));
+    }
+    else
+    {
+      value = signal.isSigned ? (double)(int64_t)raw : (double)raw;
+    }
+    value = floor(value*signal.factor + signal.offset + 0.5);
+    int32_t stored = (value>2147483647.0) ? 2147483647 : (value<-2147483648.0) ? (-2147483647-1) : (int32_t)value;
+
+    void* p = V2XBsmFieldPtr(bsm, signal.field);
+    if (kBsmFields[signal.field].caplType=='C')
+    {
+      snprintf((char*)p, kBsmFields[signal.field].size, "%d", stored);
+    }
+    else
+    {
+      memcpy(p, &stored, sizeof(stored));
+    }
+    written |= V2XBsmBit(signal.field);
+  }
+  return written;
+}
@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_signal_map.h
+|
+|            Mapping of bus signals onto BSM fields, declared in the DBC
+|            by two signal attributes:
+|
+|              BA_DEF_ SG_  "V2XField" STRING ;
+|              BA_DEF_ SG_  "V2XFactor" FLOAT -1e+09 1e+09;
+|              BA_ "V2XField" SG_ 1280 VehicleSpeed "Speed";
+|              BA_ "V2XFactor" SG_ 1280 VehicleSpeed 0.277777778;
+|
+|            V2XField is the JSON key of the field (see V2X_BSM_FIELDS).
+|            V2XFactor converts the physical value of the signal into the
+|            physical unit of the field (km/h to m/s above), 1 if missing.
+|            The raw BSM value is then physical / scale of the field.
+|
+|            CAPL still does per-frame work: an "on message *" handler
+|            copies the payload and calls dllOnBusMessage once per frame,
+|            the DLL then decodes all mapped signals. VIA message sinks
+|            are not used because this tree has no VIA_CAN.h (VIACan,
+|            VIAOnCanMessage) and a CAPL DLL gets no VIANode for
+|            GetBusInterface. The DBC is read here instead of through
+|            VIDB so that the map also loads outside CANoe (bench, tests).
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "v2x_bsm.h"
+
+
+// ============================================================================
+// V2XSignalMap
+// ============================================================================
+class V2XSignalMap
+{
+public:
+  V2XSignalMap();
+
+  // Reads the messages, signals and V2X attributes of the DBC 'path'.
+  // Returns the number of mapped signals or -1 if the file cannot be read,
+  // 'error' names the first line that could not be used.
+  int32_t    Load(const char* path, std::string& error);
+  void       Clear();
+  size_t     Count() const { return mSignals.size(); }
+
+  // Decodes the mapped signals of the frame 'id' into 'bsm', returns the
+  // fields written (0 if the frame is not mapped or too short)
+  V2XBsmMask Decode(uint32_t id, const uint8_t* data, size_t length, V2XBsm& bsm) const;
+
+private:
+  struct Signal
+  {
+    uint32_t    messageId;
+    uint16_t    startBit;    // as in the DBC, MSB for Motorola
+    uint16_t    bitLength;
+    bool        motorola;    // @0
+    bool        isSigned;    // -
+    double      factor;      // DBC scaling, combined with V2XFactor and
+    double      offset;      // the field scale once the map is loaded
+    V2XBsmField field;
+  };
+
+  // first signal of 'id' in mSignals (sorted by message id)
+  size_t       Find(uint32_t id) const;
+
+  std::vector<Signal> mSignals;
+};
@@ -0,0 +1,410 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_socket.cpp
+|
+|            Platform neutral UDP transport used by the CAPL DLL.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_socket.h"
+
+#include <string.h>
+
+#include "v2x_link.h"
+#include "v2x_stats.h"
+
+#if defined(_WIN32)
+  #include <WS2tcpip.h>
+#else
+  #include <fcntl.h>
+#endif
+
+#if defined(_MSC_VER)
+  #pragma comment(lib,"ws2_32.lib")
+#endif
+
+
+// ============================================================================
+// Socket library helpers
+// ============================================================================
+
+bool V2XSocketStartup()
+{
+#if defined(_WIN32)
+  WSADATA wsaData;
+  return WSAStartup(MAKEWORD(2, 2), &wsaData)==0;
+#else
+  return true;
+#endif
+}
+
+void V2XSocketCleanup()
+{
+#if defined(_WIN32)
+  WSACleanup();
+#endif
+}
+
+void V2XCloseSocket(V2XSocketHandle s)
+{
+  if (s==V2X_INVALID_SOCKET)
+  {
+    return;
+  }
+#if defined(_WIN32)
+  closesocket(s);
+#else
+  close(s);
+#endif
+}
+
+bool V2XSetReceiveTimeout(V2XSocketHandle s, uint32_t milliseconds)
+{
+#if defined(_WIN32)
+  DWORD timeout = milliseconds;
+#else
+  timeval timeout;
+  timeout.tv_sec  = milliseconds / 1000;
+  timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+  return setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout))==0;
+}
+
+bool V2XSetNonBlocking(V2XSocketHandle s)
+{
+#if defined(_WIN32)
+  u_long enable = 1;
+  return ioctlsocket(s, FIONBIO, &enable)==0;
+#else
+  int flags = fcntl(s, F_GETFL, 0);
+  return flags>=0 && fcntl(s, F_SETFL, flags | O_NONBLOCK)==0;
+#endif
+}
+
+bool V2XSetBufferSize(V2XSocketHandle s, int option, int32_t bytes)
+{
+  if (bytes<=0)
+  {
+    return true; // keep the default of the system
+  }
+  return setsockopt(s, SOL_SOCKET, option, (const char*)&bytes, sizeof(bytes))==0;
+}
+
+
+// ============================================================================
+// V2XTransport
+// ============================================================================
+
+// Parses "addr[:port]" of 'length' characters
+static bool sParseDestination(const char* entry, size_t length, uint16_t port, sockaddr_in& destination)
+{
+  char   host[16];
+  size_t hostLength = length;
+  const char* colon = (const char*)memchr(entry, ':', length);
+  if (colon!=nullptr)
+  {
+    hostLength = colon - entry;
+    uint32_t value = 0;
+    const char* p = colon + 1;
+    if (p==entry + length)
+    {
+      return false;
+    }
+    for (; p<entry + length; ++p)
+    {
+      if (*p<'0' || *p>'9' || (value = value*10 + (*p - '0'))>65535)
+      {
+        return false;
+      }
+    }
+    port = (uint16_t)value;
+  }
+  if (hostLength==0 || hostLength>=sizeof(host) || port==0)
+  {
+    return false;
+  }
+  memcpy(host, entry, hostLength);
+  host[hostLength] = 0;
+
+  memset(&destination, 0, sizeof(destination));
+  destination.sin_family      = AF_INET;
+  destination.sin_port        = htons(port);
+  destination.sin_addr.s_addr = inet_addr(host);
+  return destination.sin_addr.s_addr!=INADDR_NONE;
+}
+
+V2XTransport::V2XTransport()
+ : mSocket(V2X_INVALID_SOCKET),
+   mDestinationCount(0),
+   mBufferSize(kDefaultSendBufferSize),
+   mMulticastTtl(kDefaultMulticastTtl),
+   mMulticastLoopback(true),
+   mLinkHeader(false),
+   mSequence(0)
+{
+  memset(mDestinations, 0, sizeof(mDestinations));
+  mMulticastInterface.s_addr = htonl(INADDR_ANY);
+}
+
+V2XTransport::~V2XTransport()
+{
+  Close();
+}
+
+bool V2XTransport::Open(const char* addr, uint16_t port)
+{
+  Close();
+
+  if (!V2XSocketStartup())
+  {
+    return false;
+  }
+
+  mSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (mSocket==V2X_INVALID_SOCKET)
+  {
+    V2XSocketCleanup();
+    return false;
+  }
+  // a full send buffer fails the datagram instead of blocking the
+  // measurement context
+  V2XSetNonBlocking(mSocket);
+  V2XSetBufferSize(mSocket, SO_SNDBUF, mBufferSize);
+  ApplyMulticast();
+
+  mDestinations[0].sin_family      = AF_INET;
+  mDestinations[0].sin_port        = htons(port);
+  mDestinations[0].sin_addr.s_addr = inet_addr(addr);
+  mDestinationCount = 1;
+  return true;
+}
+
+int32_t V2XTransport::SetDestinations(const char* destinations, uint16_t port)
+{
+  if (destinations==nullptr)
+  {
+    return -1;
+  }
+
+  sockaddr_in parsed[kMaxDestinations];
+  size_t      count = 0;
+  const char* p     = destinations;
+  while (*p!=0)
+  {
+    size_t length = strcspn(p, ",;");
+    // trim the blanks around the entry
+    const char* entry = p;
+    size_t      n     = length;
+    while (n>0 && (*entry==' ' || *entry=='\t'))
+    {
+      ++entry;
+      --n;
+    }
+    while (n>0 && (entry[n-1]==' ' || entry[n-1]=='\t'))
+    {
+      --n;
+    }
+    if (n>0)
+    {
+      if (count==kMaxDestinations || !sParseDestination(entry, n, port, parsed[count]))
+      {
+        return -1;
+      }
+      ++count;
+    }
+    p += length;
+    if (*p!=0)
+    {
+      ++p;
+    }
+  }
+  if (count==0)
+  {
+    return -1;
+  }
+
+  memcpy(mDestinations, parsed, count*sizeof(sockaddr_in));
+  mDestinationCount = count;
+  return (int32_t)count;
+}
+
+bool V2XTransport::SetMulticast(int32_t ttl, bool loopback, const char* interfaceAddr)
+{
+  in_addr multicastInterface;
+  multicastInterface.s_addr = htonl(INADDR_ANY);
+  if (interfaceAddr!=nullptr && interfaceAddr[0]!=0)
+  {
+    multicastInterface.s_addr = inet_addr(interfaceAddr);
+    if (multicastInterface.s_addr==INADDR_NONE)
+    {
+      return false;
+    }
+  }
+  mMulticastTtl       = (ttl>0 && ttl<=255) ? ttl : kDefaultMulticastTtl;
+  mMulticastLoopback  = loopback;
+  mMulticastInterface = multicastInterface;
+  ApplyMulticast();
+  return true;
+}
+
+void V2XTransport::ApplyMulticast()
+{
+  if (mSocket==V2X_INVALID_SOCKET)
+  {
+    return;
+  }
+  // harmless for unicast destinations
+  int loop = mMulticastLoopback ? 1 : 0;
+  setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_TTL,  (const char*)&mMulticastTtl,       sizeof(mMulticastTtl));
+  setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&loop,                sizeof(loop));
+  setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_IF,   (const char*)&mMulticastInterface, sizeof(mMulticastInterface));
+}
+
+void V2XTransport::SetBufferSize(int32_t bytes)
+{
+  mBufferSize = bytes;
+  if (mSocket!=V2X_INVALID_SOCKET)
+  {
+    V2XSetBufferSize(mSocket, SO_SNDBUF, bytes);
+  }
+}
+
+void V2XTransport::Close()
+{
+  if (mSocket==V2X_INVALID_SOCKET)
+  {
+    return;
+  }
+  V2XCloseSocket(mSocket);
+  mSocket = V2X_INVALID_SOCKET;
+  V2XSocketCleanup();
+}
+
+int32_t V2XTransport::Send(const void* data, size_t length)
+{
+  if (mSocket==V2X_INVALID_SOCKET)
+  {
+    return -1;
+  }
+
+  uint8_t header[kLinkHeaderSize];
+  size_t  headerSize = 0;
+  if (mLinkHeader)
+  {
+    V2XLinkHeader link = { mSequence, V2XNowNs() };
+    V2XPutLinkHeader(header, link);
+    headerSize = sizeof(header);
+  }
+  // without the header the send starts at the data buffer
+  size_t  first = mLinkHeader ? 0 : 1;
+  int64_t sent  = -1;
+#if defined(_WIN32)
+  WSABUF buffers[2];
+  buffers[0].buf = (CHAR*)header;
+  buffers[0].len = (ULONG)sizeof(header);
+  buffers[1].buf = (CHAR*)data;
+  buffers[1].len = (ULONG)length;
+  for (size_t i=0; i<mDestinationCount; ++i)
+  {
+    DWORD bytes = 0;
+    if (WSASendTo(mSocket, buffers + first, (DWORD)(2 - first), &bytes, 0, (const sockaddr*)&mDestinations[i], sizeof(sockaddr_in), nullptr, nullptr)==0)
+    {
+      sent = bytes;
+    }
+  }
+#else
+  iovec vectors[2];
+  vectors[0].iov_base = header;
+  vectors[0].iov_len  = sizeof(header);
+  vectors[1].iov_base = (void*)data;
+  vectors[1].iov_len  = length;
+  msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_namelen = sizeof(sockaddr_in);
+  message.msg_iov     = vectors + first;
+  message.msg_iovlen  = 2 - first;
+  for (size_t i=0; i<mDestinationCount; ++i)
+  {
+    message.msg_name = &mDestinations[i];
+    ssize_t bytes = sendmsg(mSocket, &message, 0);
+    if (bytes>=0)
+    {
+      sent = bytes;
+    }
+  }
+#endif
+  if (sent<0)
+  {
+    return -1;
+  }
+  // a datagram that was not sent does not use up its number
+  ++mSequence;
+  return (int32_t)(sent - headerSize);
+}
+
+int32_t V2XTransport::SendBatch(const V2XDatagram* datagrams, size_t count)
+{
+  if (mSocket==V2X_INVALID_SOCKET)
+  {
+    return 0;
+  }
+
+  int32_t sent = 0;
+#if defined(__linux__)
+  mmsghdr messages[kMaxBatch];
+  iovec   vectors[kMaxBatch][2];
+  uint8_t headers[kMaxBatch][kLinkHeaderSize];
+  while (count>0)
+  {
+    size_t   n   = (count<kMaxBatch) ? count : kMaxBatch;
+    uint64_t now = V2XNowNs();
+    memset(messages, 0, n*sizeof(mmsghdr));
+    size_t   first = mLinkHeader ? 0 : 1;
+    for (size_t i=0; i<n; ++i)
+    {
+      if (mLinkHeader)
+      {
+        V2XLinkHeader link = { mSequence + (uint32_t)i, now };
+        V2XPutLinkHeader(headers[i], link);
+      }
+      vectors[i][0].iov_base           = headers[i];
+      vectors[i][0].iov_len            = kLinkHeaderSize;
+      vectors[i][1].iov_base           = (void*)datagrams[i].data;
+      vectors[i][1].iov_len            = datagrams[i].length;
+      messages[i].msg_hdr.msg_namelen  = sizeof(sockaddr_in);
+      messages[i].msg_hdr.msg_iov      = vectors[i] + first;
+      messages[i].msg_hdr.msg_iovlen   = 2 - first;
+    }
+    // the same messages go to every destination, only the address changes
+    int result = 0;
+    for (size_t d=0; d<mDestinationCount; ++d)
+    {
+      for (size_t i=0; i<n; ++i)
+      {
+        messages[i].msg_hdr.msg_name = &mDestinations[d];
+      }
+      int accepted = sendmmsg(mSocket, messages, (unsigned int)n, 0);
+      if (accepted>result)
+      {
+        result = accepted;
+      }
+    }
+    if (result<=0)
+    {
+      break;
+    }
+    mSequence += result;
+    sent      += result;
+    datagrams += result;
+    count     -= result;
+  }
+#else
+  for (size_t i=0; i<count; ++i)
+  {
+    if (Send(datagrams[i].data, datagrams[i].length)>=0)
+    {
+      ++sent;
+    }
+  }
+#endif
+  return sent;
+}
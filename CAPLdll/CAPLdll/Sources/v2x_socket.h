@@ -0,0 +1,126 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_socket.h
+|
+|            Platform neutral UDP transport used by the CAPL DLL to exchange
+|            V2X data with the ROS / OBU bridge (Winsock and POSIX sockets).
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+  #include <WinSock2.h>
+  typedef SOCKET V2XSocketHandle;
+  typedef int    V2XSockLen;
+  #define V2X_INVALID_SOCKET INVALID_SOCKET
+#else
+  #include <sys/types.h>
+  #include <sys/socket.h>
+  #include <netinet/in.h>
+  #include <arpa/inet.h>
+  #include <unistd.h>
+  typedef int       V2XSocketHandle;
+  typedef socklen_t V2XSockLen;
+  #define V2X_INVALID_SOCKET (-1)
+#endif
+
+
+// ============================================================================
+// Socket library helpers
+//
+// On Windows every successful V2XSocketStartup must be paired with a call of
+// V2XSocketCleanup (Winsock counts the calls). On POSIX both are no-ops.
+// ============================================================================
+
+bool V2XSocketStartup();
+void V2XSocketCleanup();
+void V2XCloseSocket(V2XSocketHandle s);
+bool V2XSetReceiveTimeout(V2XSocketHandle s, uint32_t milliseconds);
+bool V2XSetNonBlocking(V2XSocketHandle s);
+// Sets SO_RCVBUF resp. SO_SNDBUF ('option'), 0 keeps the system default
+bool V2XSetBufferSize(V2XSocketHandle s, int option, int32_t bytes);
+
+
+// One datagram of a batch passed to V2XTransport::SendBatch
+struct V2XDatagram
+{
+  const void* data;
+  size_t      length;
+};
+
+
+// ============================================================================
+// V2XTransport
+//
+// A UDP socket that is opened once and reused for every datagram sent to
+// the configured destinations. With SetLinkHeader every datagram starts
+// with a link header (v2x_link.h), written from a separate buffer without
+// copying the data.
+//
+// Several consumers are reached either by a multicast group, one send per
+// datagram, or by a unicast fan-out list, one send per datagram and
+// destination. In both cases the datagram is serialized once and every
+// consumer sees the same link sequence number.
+// ============================================================================
+class V2XTransport
+{
+public:
+  V2XTransport();
+  ~V2XTransport();
+
+  // Opens a non-blocking socket towards addr:port
+  bool    Open(const char* addr, uint16_t port);
+  void    Close();
+  bool    IsOpen() const { return mSocket!=V2X_INVALID_SOCKET; }
+
+  // SO_SNDBUF of the socket, applied at once and on the next Open
+  void    SetBufferSize(int32_t bytes);
+
+  // Puts a link header in front of every datagram, off by default
+  void    SetLinkHeader(bool enable) { mLinkHeader = enable; }
+
+  // Replaces the destinations by 'destinations', a list of "addr[:port]"
+  // separated by ',' or ';', 'port' where an entry has none. A multicast
+  // group is a single entry. Returns the number of destinations, -1 and
+  // keeps the destinations if an entry is invalid or there are more than
+  // kMaxDestinations.
+  int32_t SetDestinations(const char* destinations, uint16_t port);
+  size_t  DestinationCount() const { return mDestinationCount; }
+  // TTL and loopback of multicast datagrams, applied at once and on the
+  // next Open. The loopback delivers them to consumers on the same host.
+  // 'interfaceAddr' is the address of the outgoing interface, nullptr or
+  // empty keeps the choice of the system.
+  bool    SetMulticast(int32_t ttl, bool loopback, const char* interfaceAddr);
+
+  // Sends one datagram to every destination, returns the number of bytes
+  // of 'data' sent or -1 if no destination got it (also if the send
+  // buffer is full). A destination that misses a datagram sees it as lost.
+  int32_t Send(const void* data, size_t length);
+  // Sends 'count' datagrams, on Linux with one sendmmsg call per up to
+  // kMaxBatch datagrams and destination. Returns the number of datagrams
+  // sent to at least one destination.
+  int32_t SendBatch(const V2XDatagram* datagrams, size_t count);
+
+  static const size_t  kMaxBatch              = 64;
+  static const size_t  kMaxDestinations       = 8;
+  static const int32_t kDefaultSendBufferSize = 256*1024;
+  static const int32_t kDefaultMulticastTtl   = 1;    // stays in the local network
+
+private:
+  V2XTransport(const V2XTransport&);             // not copyable
+  V2XTransport& operator=(const V2XTransport&);
+
+  void    ApplyMulticast();
+
+  V2XSocketHandle mSocket;
+  sockaddr_in     mDestinations[kMaxDestinations];
+  size_t          mDestinationCount;
+  int32_t         mBufferSize;
+  int32_t         mMulticastTtl;
+  bool            mMulticastLoopback;
+  in_addr         mMulticastInterface; // INADDR_ANY: choice of the system
+  bool            mLinkHeader;
+  uint32_t        mSequence;         // of the next datagram, kept by Open()
+};
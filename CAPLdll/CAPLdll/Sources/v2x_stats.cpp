@@ -0,0 +1,378 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_stats.cpp
+|
+|            Latency and throughput statistics of the CAPL DLL exports.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_stats.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <Windows.h>
+#else
+  #include <time.h>
+#endif
+
+
+// ============================================================================
+// Histogram layout
+//
+// Values below 2^kSubBits ns get a bucket of their own, above that every
+// power of two is split into 2^kSubBits linear buckets, so a bucket is at
+// most 12.5% wide. Values from 2^kMaxBits ns (about 18 minutes) on are
+// counted in the last bucket.
+// ============================================================================
+static const uint32_t kSubBits     = 3;
+static const uint32_t kSubCount    = 1 << kSubBits;
+static const uint32_t kMaxBits     = 40;
+static const uint32_t kBucketCount = kSubCount + (kMaxBits - kSubBits)*kSubCount;
+
+struct V2XExportStats
+{
+  std::atomic<uint64_t> calls;
+  std::atomic<uint64_t> sum;
+  std::atomic<uint64_t> minInverted;   // ~min, so 0 means no call yet
+  std::atomic<uint64_t> max;
+  std::atomic<uint32_t> buckets[kBucketCount];
+};
+
+// zero initialized, recording may start before any constructor ran
+static V2XExportStats        sExports[kStatExportCount];
+static std::atomic<uint64_t> sCounters[kStatCounterCount];
+
+
+static uint32_t sMostSignificantBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanReverse(&index, (unsigned long)(value >> 32)))
+  {
+    return index + 32;
+  }
+  _BitScanReverse(&index, (unsigned long)value);
+  return index;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+static uint32_t sBucketIndex(uint64_t nanoseconds)
+{
+  if (nanoseconds<kSubCount)
+  {
+    return (uint32_t)nanoseconds;
+  }
+  uint32_t msb = sMostSignificantBit(nanoseconds);
+  if (msb>=kMaxBits)
+  {
+    return kBucketCount - 1;
+  }
+  uint32_t shift = msb - kSubBits;
+  return kSubCount + shift*kSubCount + (uint32_t)((nanoseconds >> shift) & (kSubCount - 1));
+}
+
+// Highest value counted in a bucket
+static uint64_t sBucketUpperBound(uint32_t index)
+{
+  if (index<kSubCount)
+  {
+    return index;
+  }
+  uint32_t shift = (index - kSubCount) / kSubCount;
+  uint64_t sub   = kSubCount + (index - kSubCount) % kSubCount;
+  return ((sub + 1) << shift) - 1;
+}
+
+static void sStoreMax(std::atomic<uint64_t>& target, uint64_t value)
+{
+  uint64_t current = target.load(std::memory_order_relaxed);
+  while (value>current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+static uint32_t sClamp32(uint64_t value)
+{
+  return (value>0xffffffffu) ? 0xffffffffu : (uint32_t)value;
+}
+
+
+uint64_t V2XNowNs()
+{
+#if defined(_WIN32)
+  static LARGE_INTEGER sFrequency;
+  if (sFrequency.QuadPart==0)
+  {
+    QueryPerformanceFrequency(&sFrequency);
+  }
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  // split to avoid the overflow of counter * 1e9
+  uint64_t seconds = counter.QuadPart / sFrequency.QuadPart;
+  uint64_t rest    = counter.QuadPart % sFrequency.QuadPart;
+  return seconds*1000000000u + rest*1000000000u / sFrequency.QuadPart;
+#else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec*1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+void V2XStatRecord(V2XStatExport id, uint64_t nanoseconds)
+{
+  V2XExportStats& stats = sExports[id];
+  stats.calls.fetch_add(1, std::memory_order_relaxed);
+  stats.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+  stats.buckets[sBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  sStoreMax(stats.minInverted, ~nanoseconds);
+  sStoreMax(stats.max, nanoseconds);
+}
+
+void V2XStatAdd(V2XStatCounter counter, uint64_t value)
+{
+  sCounters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t V2XStatCounterValue(V2XStatCounter counter)
+{
+  return sCounters[counter].load(std::memory_order_relaxed);
+}
+
+
+// CAPL names in V2XStatExport order
+static const char* const kSetNames[] = {
+#define V2X_STAT_SET_NAME(field, member, type, key, scale, event, setName, getName, text) setName,
+  V2X_BSM_FIELDS(V2X_STAT_SET_NAME)
+#undef V2X_STAT_SET_NAME
+};
+static const char* const kGetNames[] = {
+#define V2X_STAT_GET_NAME(field, member, type, key, scale, event, setName, getName, text) getName,
+  V2X_BSM_FIELDS(V2X_STAT_GET_NAME)
+#undef V2X_STAT_GET_NAME
+};
+static const char* const kGetExNames[] = {
+#define V2X_STAT_GET_EX_NAME(field, member, type, key, scale, event, setName, getName, text) getName "Ex",
+  V2X_BSM_FIELDS(V2X_STAT_GET_EX_NAME)
+#undef V2X_STAT_GET_EX_NAME
+};
+static const char* const kOtherNames[kStatExportCount - kStatSetBsmFrame] = {
+  "SetBsmFrame",
+  "dllDispatchBsm",
+  "Publish",
+  "GetBsmFrame",
+  "dllOnBusMessage",
+  "LinkLatency"
+};
+
+static const char* const kCounterNames[kStatCounterCount] = {
+  "BytesSent",
+  "DatagramsSent",
+  "SendErrors",
+  "BytesReceived",
+  "DatagramsReceived",
+  "ParseFailures",
+  "RecordsDropped",
+  "DatagramsLost",
+  "DatagramsDuplicated",
+  "DatagramsReordered"
+};
+
+const char* V2XStatName(V2XStatExport id)
+{
+  if (id<kStatGetFirst)
+  {
+    return kSetNames[id - kStatSetFirst];
+  }
+  if (id<kStatGetExFirst)
+  {
+    return kGetNames[id - kStatGetFirst];
+  }
+  if (id<kStatSetBsmFrame)
+  {
+    return kGetExNames[id - kStatGetExFirst];
+  }
+  return kOtherNames[id - kStatSetBsmFrame];
+}
+
+int32_t V2XStatFind(const char* name)
+{
+  if (name==nullptr)
+  {
+    return -1;
+  }
+  for (int32_t i=0; i<kStatExportCount; ++i)
+  {
+    if (strcmp(V2XStatName((V2XStatExport)i), name)==0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int32_t V2XGetExportStats(V2XStatExport id, uint32_t* values, int32_t count)
+{
+  const V2XExportStats& stats = sExports[id];
+
+  uint64_t result[kStatValueCount];
+  uint64_t calls = stats.calls.load(std::memory_order_relaxed);
+  uint64_t max   = stats.max.load(std::memory_order_relaxed);
+  result[kStatCalls] = calls;
+  result[kStatMin]   = ~stats.minInverted.load(std::memory_order_relaxed);
+  result[kStatMean]  = (calls>0) ? stats.sum.load(std::memory_order_relaxed) / calls : 0;
+  result[kStatMax]   = max;
+
+  // percentiles from the histogram, the buckets may have moved on since
+  // the calls were read, so count them first
+  uint64_t total = 0;
+  uint32_t counts[kBucketCount];
+  for (uint32_t i=0; i<kBucketCount; ++i)
+  {
+    counts[i] = stats.buckets[i].load(std::memory_order_relaxed);
+    total    += counts[i];
+  }
+  const uint32_t  kPerMille[]   = { 500, 900, 990 };
+  const V2XStatValue kTargets[] = { kStatP50, kStatP90, kStatP99 };
+  for (int32_t p=0; p<3; ++p)
+  {
+    uint64_t rank  = (total*kPerMille[p] + 999) / 1000;
+    uint64_t seen  = 0;
+    uint64_t value = 0;
+    for (uint32_t i=0; i<kBucketCount && total>0; ++i)
+    {
+      seen += counts[i];
+      if (seen>=rank)
+      {
+        value = sBucketUpperBound(i);
+        break;
+      }
+    }
+    result[kTargets[p]] = (value>max) ? max : value;
+  }
+  if (calls==0)
+  {
+    result[kStatMin] = 0;
+  }
+
+  int32_t written = 0;
+  for (; written<count && written<kStatValueCount; ++written)
+  {
+    values[written] = sClamp32(result[written]);
+  }
+  return written;
+}
+
+void V2XResetStats()
+{
+  for (int32_t i=0; i<kStatExportCount; ++i)
+  {
+    V2XExportStats& stats = sExports[i];
+    stats.calls.store(0, std::memory_order_relaxed);
+    stats.sum.store(0, std::memory_order_relaxed);
+    stats.minInverted.store(0, std::memory_order_relaxed);
+    stats.max.store(0, std::memory_order_relaxed);
+    for (uint32_t j=0; j<kBucketCount; ++j)
+    {
+      stats.buckets[j].store(0, std::memory_order_relaxed);
+    }
+  }
+  for (int32_t i=0; i<kStatCounterCount; ++i)
+  {
+    sCounters[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+
+// ============================================================================
+// Periodic dump
+//
+// The file is written by a thread of its own, so the measurement context
+// never waits for the disk.
+// ============================================================================
+static std::mutex              sDumpMutex;
+static std::condition_variable sDumpWakeup;
+static std::thread             sDumpThread;
+static bool                    sDumpRunning = false;
+
+static void sWriteStats(FILE* file)
+{
+  fprintf(file, "# v2x stats at %llu ms\n", (unsigned long long)(V2XNowNs() / 1000000u));
+  for (int32_t i=0; i<kStatCounterCount; ++i)
+  {
+    fprintf(file, "%s %llu\n", kCounterNames[i], (unsigned long long)V2XStatCounterValue((V2XStatCounter)i));
+  }
+  fprintf(file, "# export calls min_ns mean_ns p50_ns p90_ns p99_ns max_ns\n");
+  for (int32_t i=0; i<kStatExportCount; ++i)
+  {
+    uint32_t values[kStatValueCount];
+    V2XGetExportStats((V2XStatExport)i, values, kStatValueCount);
+    if (values[kStatCalls]==0)
+    {
+      continue;
+    }
+    fprintf(file, "%s %u %u %u %u %u %u %u\n", V2XStatName((V2XStatExport)i),
+            values[kStatCalls], values[kStatMin], values[kStatMean],
+            values[kStatP50], values[kStatP90], values[kStatP99], values[kStatMax]);
+  }
+}
+
+static void sDumpLoop(std::string path, uint32_t periodMs)
+{
+  std::unique_lock<std::mutex> lock(sDumpMutex);
+  while (sDumpRunning)
+  {
+    sDumpWakeup.wait_for(lock, std::chrono::milliseconds(periodMs));
+    FILE* file = fopen(path.c_str(), "a");
+    if (file!=nullptr)
+    {
+      sWriteStats(file);
+      fclose(file);
+    }
+  }
+}
+
+bool V2XStartStatsDump(const char* path, uint32_t periodMs)
+{
+  V2XStopStatsDump();
+  if (path==nullptr || path[0]==0 || periodMs==0)
+  {
+    return true;
+  }
+
+  FILE* file = fopen(path, "a");
+  if (file==nullptr)
+  {
+    return false;
+  }
+  fclose(file);
+
+  std::lock_guard<std::mutex> lock(sDumpMutex);
+  sDumpRunning = true;
+  sDumpThread  = std::thread(sDumpLoop, std::string(path), periodMs);
+  return true;
+}
+
+void V2XStopStatsDump()
+{
+  {
+    std::lock_guard<std::mutex> lock(sDumpMutex);
+    if (!sDumpRunning)
+    {
+      return;
+    }
+    sDumpRunning = false;
+  }
+  sDumpWakeup.notify_all();
+  if (sDumpThread.joinable())
+  {
+    sDumpThread.join();
+  }
+}
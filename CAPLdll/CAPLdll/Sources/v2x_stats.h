@@ -0,0 +1,114 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_stats.h
+|
+|            Latency and throughput statistics of the CAPL DLL exports.
+|            Every instrumented export counts its calls and records its
+|            run time in a log-linear (HDR style) histogram; the transport
+|            and the receiver count bytes, datagrams and errors. All
+|            counters are relaxed atomics, recording costs two clock reads
+|            and a few uncontended increments.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "v2x_bsm.h"
+
+
+// Monotonic time in nanoseconds
+uint64_t V2XNowNs();
+
+
+// Instrumented exports, the Set, Get and GetEx function of every field
+// followed by the functions that are not generated from V2X_BSM_FIELDS
+enum V2XStatExport
+{
+  kStatSetFirst     = 0,                      // + V2XBsmField
+  kStatGetFirst     = kBsmFieldCount,         // + V2XBsmField
+  kStatGetExFirst   = 2*kBsmFieldCount,       // + V2XBsmField
+  kStatSetBsmFrame  = 3*kBsmFieldCount,
+  kStatDispatchBsm,
+  kStatPublish,                               // periodic send of the publisher timer
+  kStatGetBsmFrame,
+  kStatOnBusMessage,
+  kStatLinkLatency,                           // one-way latency of the received datagrams, see v2x_link.h
+
+  kStatExportCount
+};
+
+// Transport and receiver counters
+enum V2XStatCounter
+{
+  kStatBytesSent = 0,
+  kStatDatagramsSent,
+  kStatSendErrors,
+  kStatBytesReceived,
+  kStatDatagramsReceived,
+  kStatParseFailures,
+  kStatRecordsDropped,                        // capture buffer full, see v2x_record.h
+  kStatDatagramsLost,                         // V2XLinkMonitor
+  kStatDatagramsDuplicated,
+  kStatDatagramsReordered,
+
+  kStatCounterCount
+};
+
+// Values of V2XGetExportStats, latencies in nanoseconds
+enum V2XStatValue
+{
+  kStatCalls = 0,
+  kStatMin,
+  kStatMean,
+  kStatP50,
+  kStatP90,
+  kStatP99,
+  kStatMax,
+
+  kStatValueCount
+};
+
+
+void     V2XStatRecord(V2XStatExport id, uint64_t nanoseconds);
+void     V2XStatAdd(V2XStatCounter counter, uint64_t value);
+uint64_t V2XStatCounterValue(V2XStatCounter counter);
+
+// Export of the CAPL function 'name' (e.g. "SetSpeed"), -1 if the
+// function is not instrumented
+int32_t  V2XStatFind(const char* name);
+// CAPL name of an export
+const char* V2XStatName(V2XStatExport id);
+
+// Writes up to 'count' V2XStatValue values of 'id' into 'values'
+// (clamped to 32 bit for CAPL), returns the number written
+int32_t  V2XGetExportStats(V2XStatExport id, uint32_t* values, int32_t count);
+
+void     V2XResetStats();
+
+// Appends all statistics to 'path' every 'periodMs' milliseconds from a
+// background thread, an empty path or a period of 0 stops the dump
+bool     V2XStartStatsDump(const char* path, uint32_t periodMs);
+void     V2XStopStatsDump();
+
+
+// ============================================================================
+// V2XStatScope
+//
+// Records the time from construction to destruction for one export:
+//
+//   void appSetSpeed(int32_t speed)
+//   {
+//     V2XStatScope scope(kStatSetFirst + kBsmSpeed);
+//     ...
+// ============================================================================
+class V2XStatScope
+{
+public:
+  explicit V2XStatScope(int32_t id) : mId((V2XStatExport)id), mStart(V2XNowNs()) {}
+  ~V2XStatScope() { V2XStatRecord(mId, V2XNowNs() - mStart); }
+
+private:
+  V2XStatExport mId;
+  uint64_t      mStart;
+};
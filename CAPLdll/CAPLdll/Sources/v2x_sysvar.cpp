@@ -0,0 +1,137 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_sysvar.cpp
+|
+|            Mirror of the received BSM fields into CANoe system variables.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_sysvar.h"
+
+#include <string>
+
+#include "v2x_receiver.h"
+
+
+V2XSysVarMirror::V2XSysVarMirror()
+ : mService(nullptr),
+   mNamespace(nullptr)
+{
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    mVariables[i] = nullptr;
+    mValues[i]    = 0;
+    mWritten[i]   = false;
+  }
+}
+
+V2XSysVarMirror::~V2XSysVarMirror()
+{
+  Close();
+}
+
+bool V2XSysVarMirror::Open(VIAService* service, const char* path)
+{
+  Close();
+  if (service==nullptr || path==nullptr || path[0]==0)
+  {
+    return false;
+  }
+
+  VIANamespace* current = nullptr;
+  if (service->GetSystemVariablesRootNamespace(current)!=kVIA_OK || current==nullptr)
+  {
+    return false;
+  }
+  if (service->RegisterSystemVariablesClient(Client(), "V2X CAPL DLL")!=kVIA_OK)
+  {
+    current->Release();
+    return false;
+  }
+  mService = service;
+
+  // AddNamespace returns an existing namespace as well
+  std::string names(path);
+  size_t      begin = 0;
+  while (current!=nullptr && begin<=names.size())
+  {
+    size_t end = names.find("::", begin);
+    if (end==std::string::npos)
+    {
+      end = names.size();
+    }
+    if (end>begin)
+    {
+      VIANamespace* child = nullptr;
+      current->AddNamespace(names.substr(begin, end - begin).c_str(), child);
+      current->Release();
+      current = child;
+    }
+    begin = end + 2;
+  }
+  if (current==nullptr)
+  {
+    Close();
+    return false;
+  }
+  mNamespace = current;
+
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    const char* name = kBsmFields[i].key;
+    if (mNamespace->GetVariable(name, mVariables[i])!=kVIA_OK)
+    {
+      mVariables[i] = nullptr;
+      if (mNamespace->AddIntVariableWithInitialValue(name, 0, true, Client(), mVariables[i])!=kVIA_OK)
+      {
+        mVariables[i] = nullptr;
+      }
+    }
+    mWritten[i] = false;
+  }
+  return true;
+}
+
+void V2XSysVarMirror::Close()
+{
+  if (mService==nullptr)
+  {
+    return;
+  }
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    if (mVariables[i]!=nullptr)
+    {
+      mVariables[i]->Release();
+      mVariables[i] = nullptr;
+    }
+  }
+  if (mNamespace!=nullptr)
+  {
+    mNamespace->Release();
+    mNamespace = nullptr;
+  }
+  // removes the variables created by this client
+  mService->UnregisterSystemVariablesClient(Client());
+  mService = nullptr;
+}
+
+void V2XSysVarMirror::Update(const V2XReceiver& receiver)
+{
+  if (mService==nullptr)
+  {
+    return;
+  }
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    int32_t value = receiver.Get((V2XBsmField)i);
+    if (mVariables[i]==nullptr || (mWritten[i] && value==mValues[i]))
+    {
+      continue;
+    }
+    if (mVariables[i]->SetInteger(value, Client())==kVIA_OK)
+    {
+      mValues[i]  = value;
+      mWritten[i] = true;
+    }
+  }
+}
@@ -0,0 +1,55 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_sysvar.h
+|
+|            Mirror of the received BSM fields into CANoe system variables,
+|            one integer variable per field named after its JSON key, e.g.
+|            V2X::RemoteBsm::Speed. Variables that exist in the
+|            configuration are used as they are, missing ones are created
+|            read-only and removed again by Close().
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stdint.h>
+
+#include "../Includes/VIA.h"
+#include "v2x_bsm.h"
+
+class V2XReceiver;
+
+
+// ============================================================================
+// V2XSysVarMirror
+//
+// VIA objects may only be used in the measurement context, so Update() is
+// called from the dispatch timer after a new message arrived. It writes a
+// variable only if the field changed since the last write.
+// ============================================================================
+class V2XSysVarMirror
+{
+public:
+  V2XSysVarMirror();
+  ~V2XSysVarMirror();
+
+  // Creates or attaches the variables in the namespace 'path' ("::"
+  // separated, created if missing), returns false if the service has no
+  // system variables
+  bool Open(VIAService* service, const char* path);
+  void Close();
+  bool IsOpen() const { return mService!=nullptr; }
+
+  // Writes the fields of 'receiver' that changed
+  void Update(const V2XReceiver& receiver);
+
+private:
+  V2XSysVarMirror(const V2XSysVarMirror&);     // not copyable
+  V2XSysVarMirror& operator=(const V2XSysVarMirror&);
+
+  VIASysVarClientHandle Client() { return (VIASysVarClientHandle)this; }
+
+  VIAService*        mService;
+  VIANamespace*      mNamespace;
+  VIASystemVariable* mVariables[kBsmFieldCount];
+  int32_t            mValues[kBsmFieldCount];   // last value written
+  bool               mWritten[kBsmFieldCount];  // false until the first write
+};
@@ -0,0 +1,50 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_vehicle.cpp
+|
+|            Send state of the simulated vehicles of the CAPL DLL.
+ ----------------------------------------------------------------------------*/
+
+#include "v2x_vehicle.h"
+
+#include <string.h>
+
+
+V2XVehicleTable::V2XVehicleTable()
+{
+  V2XVehicle& vehicle = mVehicles[std::string()];
+  memset(&vehicle, 0, sizeof(vehicle));
+  mCurrent = &vehicle;
+}
+
+V2XVehicle& V2XVehicleTable::Select(const char* id)
+{
+  std::string key(id!=nullptr ? id : "");
+  Map::iterator lIter = mVehicles.find(key);
+  if (lIter==mVehicles.end())
+  {
+    Map::iterator lAnonymous = mVehicles.find(std::string());
+    lIter = mVehicles.insert(Map::value_type(key, V2XVehicle())).first;
+    if (lAnonymous!=mVehicles.end() && mCurrent==&lAnonymous->second)
+    {
+      // the fields set before the first id belong to this vehicle
+      lIter->second = lAnonymous->second;
+      mVehicles.erase(lAnonymous);
+    }
+    else
+    {
+      memset(&lIter->second, 0, sizeof(V2XVehicle));
+    }
+  }
+  mCurrent = &lIter->second;
+  return *mCurrent;
+}
+
+void V2XVehicleTable::Reset()
+{
+  V2XVehicle current = *mCurrent;
+  mVehicles.clear();
+  V2XVehicle& vehicle = mVehicles[std::string()];
+  vehicle  = current;
+  mCurrent = &vehicle;
+}
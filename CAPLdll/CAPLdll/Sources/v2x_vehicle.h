@@ -0,0 +1,61 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_vehicle.h
+|
+|            Send state of the simulated vehicles of the CAPL DLL. In the
+|            multi-vehicle mode every vehicle id set with SetId has its own
+|            BSM, all of them share the transport of the DLL.
+ ----------------------------------------------------------------------------*/
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "v2x_bsm.h"
+
+
+// ============================================================================
+// V2XVehicle
+// ============================================================================
+struct V2XVehicle
+{
+  V2XBsm     bsm;          // last value of every field set from CAPL
+  V2XBsmMask setFields;    // fields set so far
+  V2XBsmMask dirtyFields;  // fields set since the last message
+  uint32_t   sendSeq;      // number of messages sent
+  uint32_t   sendSlot;     // messages sent plus empty deltas skipped
+};
+
+
+// ============================================================================
+// V2XVehicleTable
+//
+// Vehicles by id. The table always holds the current vehicle the setters
+// write into. Before the first Select it is a vehicle without id, which
+// the first Select turns into the vehicle of the selected id.
+// ============================================================================
+class V2XVehicleTable
+{
+public:
+  typedef std::map<std::string, V2XVehicle> Map;
+
+  V2XVehicleTable();
+
+  // Makes the vehicle 'id' the current one, creating it on first use
+  V2XVehicle& Select(const char* id);
+  V2XVehicle& Current()     { return *mCurrent; }
+
+  // Keeps only the current vehicle
+  void        Reset();
+
+  size_t      Count() const { return mVehicles.size(); }
+  Map::iterator Begin()     { return mVehicles.begin(); }
+  Map::iterator End()       { return mVehicles.end(); }
+
+private:
+  V2XVehicleTable(const V2XVehicleTable&);             // not copyable
+  V2XVehicleTable& operator=(const V2XVehicleTable&);
+
+  Map         mVehicles;
+  V2XVehicle* mCurrent;
+};
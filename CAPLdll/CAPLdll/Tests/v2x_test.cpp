@@ -0,0 +1,220 @@
+/*----------------------------------------------------------------------------
+|
+| File Name: v2x_test.cpp
+|
+|            Unit tests of the V2X modules of the CAPL DLL that run
+|            without CANoe: the binary frame, the DBC signal map, the
+|            handle table and the JSON parser. Run by ctest, exits with
+|            the number of failed checks.
+|
+|            v2x_test [<dbc>]
+ ----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../Sources/v2x_bsm.h"
+#include "../Sources/v2x_frame.h"
+#include "../Sources/v2x_handle_table.h"
+#include "../Sources/v2x_json.h"
+#include "../Sources/v2x_signal_map.h"
+
+
+static int sFailures = 0;
+
+#define V2X_CHECK(condition)                                              \
+  do                                                                      \
+  {                                                                       \
+    if (!(condition))                                                     \
+    {                                                                     \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ++sFailures;                                                        \
+    }                                                                     \
+  } while (0)
+
+static int32_t sInt(const V2XBsm& bsm, V2XBsmField field)
+{
+  int32_t value;
+  memcpy(&value, V2XBsmFieldPtr(bsm, field), sizeof(value));
+  return value;
+}
+
+static const char* sText(const V2XBsm& bsm, V2XBsmField field)
+{
+  return (const char*)V2XBsmFieldPtr(bsm, field);
+}
+
+
+// ============================================================================
+// V2XEncodeFrame / V2XDecodeFrame
+// ============================================================================
+static void sTestFrameRoundTrip()
+{
+  V2XBsmFrame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.seq     = 0x01020304;
+  frame.flags   = kBsmFrameKeyframe;
+  frame.present = V2XBsmBit(kBsmSpeed) | V2XBsmBit(kBsmHeading) | V2XBsmBit(kBsmId) | V2XBsmBit(kBsmSirenUse);
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    frame.values[i] = (i==kBsmId) ? 0 : -1000*i - 7;
+  }
+  memcpy(frame.id, "veh-0001", kBsmIdLength);
+
+  uint8_t buffer[kBsmFrameSize + 16];
+  V2X_CHECK(V2XEncodeFrame(frame, buffer, kBsmFrameSize - 1)==0);
+  V2X_CHECK(V2XEncodeFrame(frame, buffer, sizeof(buffer))==kBsmFrameSize);
+
+  V2XBsmFrame decoded;
+  V2X_CHECK(V2XDecodeFrame(buffer, kBsmFrameSize, decoded));
+  V2X_CHECK(decoded.seq==frame.seq);
+  V2X_CHECK(decoded.flags==frame.flags);
+  V2X_CHECK(decoded.present==frame.present);
+  V2X_CHECK(memcmp(decoded.id, frame.id, kBsmIdLength)==0);
+  for (int32_t i=0; i<kBsmFieldCount; ++i)
+  {
+    V2X_CHECK(i==kBsmId || decoded.values[i]==frame.values[i]);
+  }
+
+  // too short or no frame at all
+  V2X_CHECK(!V2XDecodeFrame(buffer, kBsmFrameSize - 1, decoded));
+  buffer[0] = '{';
+  V2X_CHECK(!V2XDecodeFrame(buffer, kBsmFrameSize, decoded));
+}
+
+
+// ============================================================================
+// V2XSignalMap
+// ============================================================================
+static void sTestSignalMap(const char* dbc)
+{
+  V2XSignalMap map;
+  std::string  error;
+  V2X_CHECK(map.Load(dbc, error)==10);
+  if (!error.empty())
+  {
+    printf("%s\n", error.c_str());
+  }
+
+  // VehicleStatus (1282): YawRate 7|16@0- and SteeringWheelAngle 23|16@0-
+  // are Motorola, BrakePedal 32|2@1+ and Transmission 34|3@1+ Intel
+  const uint8_t status[8] = { 0xFF, 0x38, 0x00, 0x96, 0x16, 0x00, 0x00, 0x00 };
+  V2XBsm bsm;
+  memset(&bsm, 0, sizeof(bsm));
+  V2XBsmMask fields = map.Decode(1282, status, sizeof(status), bsm);
+  V2X_CHECK(fields==(V2XBsmBit(kBsmYawRate) | V2XBsmBit(kBsmWheelAngle) | V2XBsmBit(kBsmBrakePadel) | V2XBsmBit(kBsmTransmission)));
+  V2X_CHECK(sInt(bsm, kBsmYawRate)==-200);        // 0xFF38 * 0.01 deg/s in 0.01 deg/s
+  V2X_CHECK(sInt(bsm, kBsmWheelAngle)==10);       // 0x0096 * 0.1 deg in 1.5 deg
+  V2X_CHECK(sInt(bsm, kBsmBrakePadel)==2);
+  V2X_CHECK(sInt(bsm, kBsmTransmission)==5);
+
+  const uint8_t positive[8] = { 0x12, 0x34, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+  map.Decode(1282, positive, sizeof(positive), bsm);
+  V2X_CHECK(sInt(bsm, kBsmYawRate)==0x1234);
+
+  // signals that do not fit into a short frame are skipped, the Motorola
+  // SteeringWheelAngle ends in byte 3
+  V2X_CHECK(map.Decode(1282, status, 3, bsm)==V2XBsmBit(kBsmYawRate));
+  V2X_CHECK(map.Decode(0x7ff, status, sizeof(status), bsm)==0);
+}
+
+
+// ============================================================================
+// V2XHandleTable
+// ============================================================================
+static void sTestHandleTable()
+{
+  // all handles below start probing at slot 1
+  V2XHandleTable<int, 4> table;
+  int a = 1;
+  int b = 2;
+  int c = 3;
+  int d = 4;
+
+  V2X_CHECK(table.Insert(1, &a));
+  V2X_CHECK(table.Insert(5, &b));
+  V2X_CHECK(table.Insert(9, &c));
+  V2X_CHECK(table.Find(5)==&b);
+  V2X_CHECK(table.Find(13)==nullptr);
+
+  // the tombstone of 5 does not end the probe sequence of 9
+  V2X_CHECK(table.Remove(5)==&b);
+  V2X_CHECK(table.Find(5)==nullptr);
+  V2X_CHECK(table.Find(9)==&c);
+  V2X_CHECK(table.Remove(5)==nullptr);
+
+  // a new handle reuses the tombstone
+  V2X_CHECK(table.Insert(13, &d));
+  uint32_t handle = 0;
+  V2X_CHECK(table.At(2, &handle)==&d && handle==13);
+
+  // replace, then fill the last free slot
+  V2X_CHECK(table.Insert(13, &b));
+  V2X_CHECK(table.Find(13)==&b);
+  V2X_CHECK(table.Insert(17, &a));
+  V2X_CHECK(!table.Insert(21, &a));
+  V2X_CHECK(table.Find(17)==&a);
+}
+
+
+// ============================================================================
+// V2XParseBsm
+// ============================================================================
+static void sTestParseBsm()
+{
+  V2XBsm     bsm;
+  V2XBsmMask present;
+  memset(&bsm, 0, sizeof(bsm));
+
+  // flat document as sent by the DLL and the bridges
+  const char* flat = "{\"Latitude\":399000000,\"Speed\":1389,\"Heading\":9000,\"Id\":\"veh-01\",\"Events\":\"0x10\"}";
+  V2X_CHECK(V2XParseBsm(flat, strlen(flat), bsm, present));
+  V2X_CHECK(present==(V2XBsmBit(kBsmLatitude) | V2XBsmBit(kBsmSpeed) | V2XBsmBit(kBsmHeading) | V2XBsmBit(kBsmId) | V2XBsmBit(kBsmEvents)));
+  V2X_CHECK(sInt(bsm, kBsmLatitude)==399000000);
+  V2X_CHECK(sInt(bsm, kBsmSpeed)==1389);
+  V2X_CHECK(sInt(bsm, kBsmHeading)==9000);
+  V2X_CHECK(strcmp(sText(bsm, kBsmId), "veh-01")==0);
+  V2X_CHECK(strcmp(sText(bsm, kBsmEvents), "0x10")==0);
+
+  // delta document: only the changed fields, Seq and Keyframe are skipped
+  const char* delta = "{\"Speed\":1400,\"Seq\":7,\"Keyframe\":0}";
+  V2X_CHECK(V2XParseBsm(delta, strlen(delta), bsm, present));
+  V2X_CHECK(present==V2XBsmBit(kBsmSpeed));
+  V2X_CHECK(sInt(bsm, kBsmSpeed)==1400);
+  V2X_CHECK(sInt(bsm, kBsmHeading)==9000);
+
+  // malformed documents
+  const char* malformed[] = {
+    "",
+    "not json",
+    "{\"Speed\":13",
+    "{\"Speed\" 13}",
+    "[1389]"
+  };
+  for (size_t i=0; i<sizeof(malformed)/sizeof(malformed[0]); ++i)
+  {
+    V2X_CHECK(!V2XParseBsm(malformed[i], strlen(malformed[i]), bsm, present));
+  }
+}
+
+
+int main(int argc, char* argv[])
+{
+#if defined(V2X_TEST_DBC)
+  const char* dbc = V2X_TEST_DBC;
+#else
+  const char* dbc = "../EXAMPLE/dbc/CAPLdll.dbc";
+#endif
+  if (argc>1)
+  {
+    dbc = argv[1];
+  }
+
+  sTestFrameRoundTrip();
+  sTestSignalMap(dbc);
+  sTestHandleTable();
+  sTestParseBsm();
+
+  printf("%s: %d failed checks\n", (sFailures==0) ? "passed" : "FAILED", sFailures);
+  return sFailures;
+}
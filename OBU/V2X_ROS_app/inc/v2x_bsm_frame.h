@@ -0,0 +1,149 @@
+/**
+  * @file      v2x_bsm_frame.h
+  * @brief     Binary BSM frame exchanged with the CAPL DLL and the ROS node
+  *
+  * Same layout as CAPLdll/CAPLdll/Sources/v2x_frame.h, little-endian:
+  *
+  * | offset | size | content |
+  * | ------ | ---- | ------- |
+  * | 0  | 4   | magic "V2XB" |
+  * | 4  | 1   | version |
+  * | 5  | 1   | flags, bit 0: keyframe |
+  * | 6  | 2   | reserved, 0 |
+  * | 8  | 4   | sequence number |
+  * | 12 | 8   | present mask, bit n: field n is valid |
+  * | 20 | 144 | fields in v2x_bsm_field_enum order, int32 each, except id: 8 characters |
+  *
+  * The field values are the raw integers of the CAPL Set* functions, see
+  * the BSM_SCALE_* constants for their units.
+  */
+#ifndef _V2X_BSM_FRAME_H_
+#define _V2X_BSM_FRAME_H_
+
+#include <stdint.h>
+#include "v2x_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSM_FRAME_VERSION       1
+#define BSM_FRAME_SIZE          164
+#define BSM_FRAME_KEYFRAME      0x01    ///< flags
+
+#define BSM_SCALE_LATLNG        1e-7    ///< degree
+#define BSM_SCALE_SPEED         0.02    ///< m/s
+#define BSM_SCALE_HEADING       0.0125  ///< degree
+#define BSM_SCALE_ACCEL         0.01    ///< m/s^2
+#define BSM_SCALE_YAW_RATE      0.01    ///< degree/s
+#define BSM_SCALE_ELEVATION     0.1     ///< m
+#define BSM_SCALE_SEMI_AXIS     0.05    ///< m
+#define BSM_SCALE_ORIENTATION   0.0054932479 ///< degree
+#define BSM_SCALE_WIDTH_LENGTH  0.01    ///< m
+#define BSM_SCALE_HEIGHT        0.05    ///< m
+
+/**
+  * @brief BSM fields, same order as V2XBsmField in the CAPL DLL
+  */
+typedef enum
+{
+    BSM_FIELD_LATITUDE = 0,
+    BSM_FIELD_LONGTITUDE,
+    BSM_FIELD_TRANSMISSION,
+    BSM_FIELD_SPEED,
+    BSM_FIELD_HEADING,
+    BSM_FIELD_ACC_LAT,
+    BSM_FIELD_ACC_LNG,
+    BSM_FIELD_VEH_CLASS,
+    BSM_FIELD_EVENTS,
+    BSM_FIELD_RESPONSE_TYPE,
+    BSM_FIELD_LIGHTS_USE,
+    BSM_FIELD_ID,
+    BSM_FIELD_TIME_STAMP,
+    BSM_FIELD_ELEVATION,
+    BSM_FIELD_SMAJOR_DEV,
+    BSM_FIELD_SMINOR_DEV,
+    BSM_FIELD_SMAJOR_ORIEN,
+    BSM_FIELD_POS_CONFIDENCE_POS,
+    BSM_FIELD_POS_CONFIDENCE_ELE,
+    BSM_FIELD_WHEEL_ANGLE,
+    BSM_FIELD_ACC_VERT,
+    BSM_FIELD_YAW_RATE,
+    BSM_FIELD_BRAKE_PADEL,
+    BSM_FIELD_WHEEL_BRAKES,
+    BSM_FIELD_TRACTION,
+    BSM_FIELD_ABS,
+    BSM_FIELD_SCS,
+    BSM_FIELD_BRAKE_BOOST,
+    BSM_FIELD_AUX_BRAKES,
+    BSM_FIELD_VEH_WIDTH,
+    BSM_FIELD_VEH_LEN,
+    BSM_FIELD_VEH_HEIGHT,
+    BSM_FIELD_VEH_FUEL_TYPE,
+    BSM_FIELD_LIGHTS,
+    BSM_FIELD_SIREN_USE,
+    BSM_FIELD_COUNT
+} v2x_bsm_field_enum;
+
+#define BSM_FIELD_BIT(field)    ((uint64_t)1 << (field))
+
+/**
+  * @brief Decoded BSM frame, values[BSM_FIELD_ID] is not used
+  */
+typedef struct
+{
+    uint32_t    seq;                        ///< sequence number
+    uint8_t     flags;                      ///< BSM_FRAME_KEYFRAME
+    uint64_t    present;                    ///< valid fields
+    int32_t     values[BSM_FIELD_COUNT];    ///< raw field values
+    char        id[MAX_ID_LEN];             ///< id, not NUL terminated if 8 characters
+} v2x_bsm_frame_struct;
+
+/**
+  * @brief      Checks the magic of a received datagram
+  * @return     1 for a BSM frame, 0 otherwise
+  */
+int is_bsm_frame(const char *in_buf, int in_len);
+
+/**
+  * @brief      Encodes a BSM frame
+  * @param[in]  frame       frame to encode
+  * @param[out] out_buf     buffer of at least BSM_FRAME_SIZE bytes
+  * @return     number of bytes written, -1 if the buffer is too small
+  */
+int encode_bsm_frame(const v2x_bsm_frame_struct *frame, char *out_buf, int out_len);
+
+/**
+  * @brief      Decodes a BSM frame
+  * @retval     0       success
+  * @retval     -1      no BSM frame
+  */
+int decode_bsm_frame(const char *in_buf, int in_len, v2x_bsm_frame_struct *frame);
+
+/**
+  * @brief      Fills all fields of a frame from a BSM, optional fields only if present
+  */
+void bsm_frame_from_struct(const v2x_bsm_struct *bsm, v2x_bsm_frame_struct *frame);
+
+/**
+  * @brief      Copies the present fields of a frame into a BSM
+  */
+void bsm_frame_to_struct(const v2x_bsm_frame_struct *frame, v2x_bsm_struct *bsm);
+
+/**
+  * @brief      JSON key of a field in the flat documents of the CAPL DLL
+  * @return     key like "Speed", NULL for an invalid field
+  */
+const char *bsm_field_key(int field);
+
+/**
+  * @brief      Delta mode: copies the present fields of 'delta' into 'state'
+  *             and adds them to its present mask
+  */
+void bsm_frame_merge(v2x_bsm_frame_struct *state, const v2x_bsm_frame_struct *delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+/**
+  * @file      v2x_link.h
+  * @brief     Link header of the UDP datagrams between the CAPL DLL, this
+  *            bridge and the ROS node, and the receiver side accounting
+  *
+  * Same layout as CAPLdll/CAPLdll/Sources/v2x_link.h, little-endian:
+  *
+  * | offset | size | content |
+  * | ------ | ---- | ------- |
+  * | 0  | 4 | magic "V2XH" |
+  * | 4  | 4 | sequence number, +1 per datagram of the sender |
+  * | 8  | 8 | CLOCK_MONOTONIC send time in ns |
+  * | 16 |   | JSON document or binary BSM frame |
+  *
+  * The header is optional, datagrams of WMS have none. The latency is only
+  * the one-way latency if sender and receiver run on the same host.
+  */
+#ifndef _V2X_LINK_H_
+#define _V2X_LINK_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINK_HEADER_SIZE        16
+#define LINK_WINDOW             64      ///< sequence numbers followed by the monitor
+
+/**
+  * @brief Receiver accounting of one sender
+  *
+  * lost: not received before LINK_WINDOW newer datagrams arrived,
+  * duplicated: received twice within the window, reordered: received after
+  * a newer datagram within the window. Two consecutive datagrams from
+  * before the window restart the sender.
+  */
+typedef struct
+{
+    int         started;
+    uint32_t    highest;                ///< newest sequence number
+    uint32_t    last;                   ///< sequence number of the previous datagram
+    uint64_t    window;                 ///< bit n: highest - n was received
+    uint64_t    received;
+    uint64_t    lost;
+    uint64_t    duplicated;
+    uint64_t    reordered;
+    uint64_t    latency_min_ns;
+    uint64_t    latency_max_ns;
+    uint64_t    latency_sum_ns;
+    uint64_t    latency_count;
+} v2x_link_monitor_struct;
+
+/**
+  * @brief      CLOCK_MONOTONIC in ns
+  */
+uint64_t link_now_ns(void);
+
+/**
+  * @brief      Writes the header of datagram 'seq' with the current time
+  * @param[out] out_buf     buffer of at least LINK_HEADER_SIZE bytes
+  */
+void put_link_header(char *out_buf, uint32_t seq);
+
+/**
+  * @brief      Reads the header at the start of a received datagram
+  * @return     LINK_HEADER_SIZE, 0 if the datagram has no header
+  */
+int get_link_header(const char *in_buf, int in_len, uint32_t *seq, uint64_t *send_ns);
+
+/**
+  * @brief      Accounts a received datagram
+  */
+void link_monitor_receive(v2x_link_monitor_struct *monitor, uint32_t seq, uint64_t send_ns, uint64_t now_ns);
+
+/**
+  * @brief      Prints the counters and the latency in us
+  */
+void link_monitor_print(const v2x_link_monitor_struct *monitor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
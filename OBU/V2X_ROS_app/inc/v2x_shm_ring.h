@@ -0,0 +1,67 @@
+/**
+  * @file      v2x_shm_ring.h
+  * @brief     Reader of the shared memory ring written by the CAPL DLL
+  *
+  * Same layout as CAPLdll/CAPLdll/Sources/v2x_shm.h, little-endian uint32:
+  *
+  * | offset | content |
+  * | ------ | ------- |
+  * | 0   | magic "V2XR" |
+  * | 4   | version |
+  * | 8   | slot size in bytes |
+  * | 12  | slot count, a power of two |
+  * | 16  | frames dropped by the writer because the ring was full |
+  * | 64  | head: number of frames written, futex word |
+  * | 68  | waiters: not 0 while a reader sleeps on head |
+  * | 128 | tail: number of frames read |
+  * | 256 | slots: sequence number, length, frame |
+  *
+  * One reader per ring. The slots hold binary BSM frames, see v2x_bsm_frame.h.
+  */
+#ifndef _V2X_SHM_RING_H_
+#define _V2X_SHM_RING_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define V2X_SHM_RING_VERSION    1
+
+/**
+  * @brief Attached ring
+  */
+typedef struct
+{
+    unsigned char   *base;          ///< mapping, NULL if not attached
+    unsigned long   size;           ///< size of the mapping
+    uint32_t        lost;           ///< frames skipped because the reader fell behind
+} v2x_shm_ring_struct;
+
+/**
+  * @brief      Attaches the ring 'name' created by the CAPL DLL (dllSetSharedMemory)
+  * @retval     0       success
+  * @retval     -1      the ring does not exist (yet) or has another version
+  */
+int v2x_shm_ring_open(v2x_shm_ring_struct *ring, const char *name);
+
+/**
+  * @brief      Takes the next frame from the ring
+  * @param[in]  timeout_ms  time to sleep for a frame, 0 returns at once, -1 waits forever
+  * @return     length of the frame, 0 on timeout, -1 if the frame does not fit into out_buf
+  */
+int v2x_shm_ring_read(v2x_shm_ring_struct *ring, char *out_buf, int out_len, int timeout_ms);
+
+/**
+  * @brief      Frames the writer dropped because the ring was full
+  */
+uint32_t v2x_shm_ring_dropped(const v2x_shm_ring_struct *ring);
+
+void v2x_shm_ring_close(v2x_shm_ring_struct *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,228 @@
+#include <string.h>
+#include <math.h>
+#include "v2x_bsm_frame.h"
+
+#define BSM_FRAME_HEADER_SIZE 20
+
+#define TO_RAW(v, scale)    ((int32_t)lround((v) / (scale)))
+#define FROM_RAW(v, scale)  ((double)(v) * (scale))
+
+static const char s_magic[4] = { 'V', '2', 'X', 'B' };
+
+// JSON keys in v2x_bsm_field_enum order, like V2X_BSM_FIELDS of the CAPL DLL
+static const char *const s_keys[BSM_FIELD_COUNT] =
+{
+    "Latitude", "Longtitude", "Transmission", "Speed", "Heading",
+    "Acc_Lat", "Acc_Lng", "Veh_Class", "Events", "Response_Type",
+    "Lights_Use", "Id", "time_stamp", "Elevation", "Smajor_dev",
+    "Sminor_dev", "Smajor_Orien", "Pos_Confidence_Pos", "Pos_Confidence_Ele", "Wheel_Angle",
+    "Acc_Vert", "Yaw_Rate", "Brake_Padel", "Wheel_Brakes", "Traction",
+    "ABS", "SCS", "Brake_Boost", "Aux_Brakes", "Veh_Width",
+    "Veh_Len", "Veh_Height", "Veh_Fuel_Type", "Lights", "Siren_Use"
+};
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// offset of a field in the frame, the id takes 8 instead of 4 bytes
+static int field_offset(int field)
+{
+    int offset = BSM_FRAME_HEADER_SIZE + 4 * field;
+    if (field > BSM_FIELD_ID)
+    {
+        offset += MAX_ID_LEN - 4;
+    }
+    return offset;
+}
+
+int is_bsm_frame(const char *in_buf, int in_len)
+{
+    return in_len >= BSM_FRAME_SIZE && memcmp(in_buf, s_magic, sizeof(s_magic)) == 0;
+}
+
+int encode_bsm_frame(const v2x_bsm_frame_struct *frame, char *out_buf, int out_len)
+{
+    unsigned char *p = (unsigned char *)out_buf;
+    int i;
+    if (out_len < BSM_FRAME_SIZE)
+    {
+        return -1;
+    }
+    memcpy(p, s_magic, sizeof(s_magic));
+    p[4] = BSM_FRAME_VERSION;
+    p[5] = frame->flags;
+    p[6] = 0;
+    p[7] = 0;
+    put32(p + 8, frame->seq);
+    put32(p + 12, (uint32_t)frame->present);
+    put32(p + 16, (uint32_t)(frame->present >> 32));
+    for (i = 0; i < BSM_FIELD_COUNT; i++)
+    {
+        if (i == BSM_FIELD_ID)
+        {
+            memcpy(p + field_offset(i), frame->id, MAX_ID_LEN);
+        }
+        else
+        {
+            put32(p + field_offset(i), (uint32_t)frame->values[i]);
+        }
+    }
+    return BSM_FRAME_SIZE;
+}
+
+int decode_bsm_frame(const char *in_buf, int in_len, v2x_bsm_frame_struct *frame)
+{
+    const unsigned char *p = (const unsigned char *)in_buf;
+    int i;
+    // later versions only append data
+    if (!is_bsm_frame(in_buf, in_len) || p[4] < BSM_FRAME_VERSION)
+    {
+        return -1;
+    }
+    frame->flags = p[5];
+    frame->seq = get32(p + 8);
+    frame->present = ((uint64_t)get32(p + 12) | ((uint64_t)get32(p + 16) << 32))
+                   & (BSM_FIELD_BIT(BSM_FIELD_COUNT) - 1);
+    for (i = 0; i < BSM_FIELD_COUNT; i++)
+    {
+        if (i == BSM_FIELD_ID)
+        {
+            memcpy(frame->id, p + field_offset(i), MAX_ID_LEN);
+            frame->values[i] = 0;
+        }
+        else
+        {
+            frame->values[i] = (int32_t)get32(p + field_offset(i));
+        }
+    }
+    return 0;
+}
+
+#define SET(field, value)           do { frame->values[field] = (value); frame->present |= BSM_FIELD_BIT(field); } while (0)
+#define SET_OPT(opt, field, value)  do { if (opt) { SET(field, value); } } while (0)
+
+void bsm_frame_from_struct(const v2x_bsm_struct *bsm, v2x_bsm_frame_struct *frame)
+{
+    const v2x_veh_emergency_ext_struct *ext = &bsm->veh_emergency_ext;
+    memset(frame->values, 0, sizeof(frame->values));
+    frame->present = 0;
+
+    SET(BSM_FIELD_LATITUDE, TO_RAW(bsm->pos.latitude, BSM_SCALE_LATLNG));
+    SET(BSM_FIELD_LONGTITUDE, TO_RAW(bsm->pos.longitude, BSM_SCALE_LATLNG));
+    SET_OPT(bsm->trans_opt, BSM_FIELD_TRANSMISSION, bsm->trans);
+    SET(BSM_FIELD_SPEED, TO_RAW(bsm->speed, BSM_SCALE_SPEED));
+    SET(BSM_FIELD_HEADING, TO_RAW(bsm->heading, BSM_SCALE_HEADING));
+    SET_OPT(bsm->accel_set.acc_lat_opt, BSM_FIELD_ACC_LAT, TO_RAW(bsm->accel_set.acc_lat, BSM_SCALE_ACCEL));
+    SET(BSM_FIELD_ACC_LNG, TO_RAW(bsm->accel_set.acc_lng, BSM_SCALE_ACCEL));
+    SET(BSM_FIELD_VEH_CLASS, bsm->vehicle_classification.classification);
+    SET_OPT(bsm->events_opt, BSM_FIELD_EVENTS, bsm->events);
+    SET_OPT(bsm->veh_emergency_ext_opt && ext->response_type_opt, BSM_FIELD_RESPONSE_TYPE, ext->response_type);
+    SET_OPT(bsm->veh_emergency_ext_opt && ext->lights_use_opt, BSM_FIELD_LIGHTS_USE, ext->lights_use);
+    memcpy(frame->id, bsm->id, MAX_ID_LEN);
+    frame->present |= BSM_FIELD_BIT(BSM_FIELD_ID);
+    SET(BSM_FIELD_TIME_STAMP, (int32_t)bsm->time_stamp);
+    SET_OPT(bsm->pos.elevation_opt, BSM_FIELD_ELEVATION, TO_RAW(bsm->pos.elevation, BSM_SCALE_ELEVATION));
+    SET_OPT(bsm->pos_acc_opt, BSM_FIELD_SMAJOR_DEV, TO_RAW(bsm->pos_acc.smajor_dev, BSM_SCALE_SEMI_AXIS));
+    SET_OPT(bsm->pos_acc_opt, BSM_FIELD_SMINOR_DEV, TO_RAW(bsm->pos_acc.sminor_dev, BSM_SCALE_SEMI_AXIS));
+    SET_OPT(bsm->pos_acc_opt, BSM_FIELD_SMAJOR_ORIEN, TO_RAW(bsm->pos_acc.smajor_orien, BSM_SCALE_ORIENTATION));
+    SET_OPT(bsm->pos_confidence_opt, BSM_FIELD_POS_CONFIDENCE_POS, bsm->pos_confidence.pos);
+    SET_OPT(bsm->pos_confidence_opt && bsm->pos_confidence.elevation_opt, BSM_FIELD_POS_CONFIDENCE_ELE, bsm->pos_confidence.elevation);
+    SET_OPT(bsm->angle_opt, BSM_FIELD_WHEEL_ANGLE, bsm->angle);
+    SET_OPT(bsm->accel_set.acc_vert_opt, BSM_FIELD_ACC_VERT, TO_RAW(bsm->accel_set.acc_vert, BSM_SCALE_ACCEL));
+    SET(BSM_FIELD_YAW_RATE, TO_RAW(bsm->accel_set.yaw_rate, BSM_SCALE_YAW_RATE));
+    SET_OPT(bsm->brakes.brake_padel_opt, BSM_FIELD_BRAKE_PADEL, bsm->brakes.brake_padel);
+    SET_OPT(bsm->brakes.wheel_brakes_opt, BSM_FIELD_WHEEL_BRAKES, bsm->brakes.wheel_brakes);
+    SET_OPT(bsm->brakes.traction_opt, BSM_FIELD_TRACTION, bsm->brakes.traction);
+    SET_OPT(bsm->brakes.abs_opt, BSM_FIELD_ABS, bsm->brakes.abs);
+    SET_OPT(bsm->brakes.scs_opt, BSM_FIELD_SCS, bsm->brakes.scs);
+    SET_OPT(bsm->brakes.brake_boost_opt, BSM_FIELD_BRAKE_BOOST, bsm->brakes.brake_boost);
+    SET_OPT(bsm->brakes.aux_brakes_opt, BSM_FIELD_AUX_BRAKES, bsm->brakes.aux_brakes);
+    SET(BSM_FIELD_VEH_WIDTH, TO_RAW(bsm->veh_size.width, BSM_SCALE_WIDTH_LENGTH));
+    SET(BSM_FIELD_VEH_LEN, TO_RAW(bsm->veh_size.length, BSM_SCALE_WIDTH_LENGTH));
+    SET_OPT(bsm->veh_size.height_opt, BSM_FIELD_VEH_HEIGHT, TO_RAW(bsm->veh_size.height, BSM_SCALE_HEIGHT));
+    SET_OPT(bsm->vehicle_classification.fuel_type_opt, BSM_FIELD_VEH_FUEL_TYPE, bsm->vehicle_classification.fuel_type);
+    SET_OPT(bsm->lights_opt, BSM_FIELD_LIGHTS, bsm->lights);
+    SET_OPT(bsm->veh_emergency_ext_opt && ext->siren_use_opt, BSM_FIELD_SIREN_USE, ext->siren_use);
+}
+
+#define HAS(field)  ((frame->present & BSM_FIELD_BIT(field)) != 0)
+#define RAW(field)  (frame->values[field])
+
+void bsm_frame_to_struct(const v2x_bsm_frame_struct *frame, v2x_bsm_struct *bsm)
+{
+    v2x_veh_emergency_ext_struct *ext = &bsm->veh_emergency_ext;
+
+    if (HAS(BSM_FIELD_LATITUDE))    { bsm->pos.latitude = FROM_RAW(RAW(BSM_FIELD_LATITUDE), BSM_SCALE_LATLNG); }
+    if (HAS(BSM_FIELD_LONGTITUDE))  { bsm->pos.longitude = FROM_RAW(RAW(BSM_FIELD_LONGTITUDE), BSM_SCALE_LATLNG); }
+    if (HAS(BSM_FIELD_TRANSMISSION)) { bsm->trans_opt = true; bsm->trans = RAW(BSM_FIELD_TRANSMISSION); }
+    if (HAS(BSM_FIELD_SPEED))       { bsm->speed = FROM_RAW(RAW(BSM_FIELD_SPEED), BSM_SCALE_SPEED); }
+    if (HAS(BSM_FIELD_HEADING))     { bsm->heading = FROM_RAW(RAW(BSM_FIELD_HEADING), BSM_SCALE_HEADING); }
+    if (HAS(BSM_FIELD_ACC_LAT))     { bsm->accel_set.acc_lat_opt = true; bsm->accel_set.acc_lat = FROM_RAW(RAW(BSM_FIELD_ACC_LAT), BSM_SCALE_ACCEL); }
+    if (HAS(BSM_FIELD_ACC_LNG))     { bsm->accel_set.acc_lng = FROM_RAW(RAW(BSM_FIELD_ACC_LNG), BSM_SCALE_ACCEL); }
+    if (HAS(BSM_FIELD_VEH_CLASS))   { bsm->vehicle_classification.classification = RAW(BSM_FIELD_VEH_CLASS); }
+    if (HAS(BSM_FIELD_EVENTS))      { bsm->events_opt = true; bsm->events = RAW(BSM_FIELD_EVENTS); }
+    if (HAS(BSM_FIELD_RESPONSE_TYPE)) { bsm->veh_emergency_ext_opt = true; ext->response_type_opt = true; ext->response_type = RAW(BSM_FIELD_RESPONSE_TYPE); }
+    if (HAS(BSM_FIELD_LIGHTS_USE))  { bsm->veh_emergency_ext_opt = true; ext->lights_use_opt = true; ext->lights_use = RAW(BSM_FIELD_LIGHTS_USE); }
+    if (HAS(BSM_FIELD_ID))          { memcpy(bsm->id, frame->id, MAX_ID_LEN); }
+    if (HAS(BSM_FIELD_TIME_STAMP))  { bsm->time_stamp = RAW(BSM_FIELD_TIME_STAMP); }
+    if (HAS(BSM_FIELD_ELEVATION))   { bsm->pos.elevation_opt = true; bsm->pos.elevation = FROM_RAW(RAW(BSM_FIELD_ELEVATION), BSM_SCALE_ELEVATION); }
+    if (HAS(BSM_FIELD_SMAJOR_DEV))  { bsm->pos_acc_opt = true; bsm->pos_acc.smajor_dev = FROM_RAW(RAW(BSM_FIELD_SMAJOR_DEV), BSM_SCALE_SEMI_AXIS); }
+    if (HAS(BSM_FIELD_SMINOR_DEV))  { bsm->pos_acc_opt = true; bsm->pos_acc.sminor_dev = FROM_RAW(RAW(BSM_FIELD_SMINOR_DEV), BSM_SCALE_SEMI_AXIS); }
+    if (HAS(BSM_FIELD_SMAJOR_ORIEN)) { bsm->pos_acc_opt = true; bsm->pos_acc.smajor_orien = FROM_RAW(RAW(BSM_FIELD_SMAJOR_ORIEN), BSM_SCALE_ORIENTATION); }
+    if (HAS(BSM_FIELD_POS_CONFIDENCE_POS)) { bsm->pos_confidence_opt = true; bsm->pos_confidence.pos = RAW(BSM_FIELD_POS_CONFIDENCE_POS); }
+    if (HAS(BSM_FIELD_POS_CONFIDENCE_ELE)) { bsm->pos_confidence_opt = true; bsm->pos_confidence.elevation_opt = true; bsm->pos_confidence.elevation = RAW(BSM_FIELD_POS_CONFIDENCE_ELE); }
+    if (HAS(BSM_FIELD_WHEEL_ANGLE)) { bsm->angle_opt = true; bsm->angle = RAW(BSM_FIELD_WHEEL_ANGLE); }
+    if (HAS(BSM_FIELD_ACC_VERT))    { bsm->accel_set.acc_vert_opt = true; bsm->accel_set.acc_vert = FROM_RAW(RAW(BSM_FIELD_ACC_VERT), BSM_SCALE_ACCEL); }
+    if (HAS(BSM_FIELD_YAW_RATE))    { bsm->accel_set.yaw_rate = FROM_RAW(RAW(BSM_FIELD_YAW_RATE), BSM_SCALE_YAW_RATE); }
+    if (HAS(BSM_FIELD_BRAKE_PADEL)) { bsm->brakes.brake_padel_opt = true; bsm->brakes.brake_padel = RAW(BSM_FIELD_BRAKE_PADEL); }
+    if (HAS(BSM_FIELD_WHEEL_BRAKES)) { bsm->brakes.wheel_brakes_opt = true; bsm->brakes.wheel_brakes = RAW(BSM_FIELD_WHEEL_BRAKES); }
+    if (HAS(BSM_FIELD_TRACTION))    { bsm->brakes.traction_opt = true; bsm->brakes.traction = RAW(BSM_FIELD_TRACTION); }
+    if (HAS(BSM_FIELD_ABS))         { bsm->brakes.abs_opt = true; bsm->brakes.abs = RAW(BSM_FIELD_ABS); }
+    if (HAS(BSM_FIELD_SCS))         { bsm->brakes.scs_opt = true; bsm->brakes.scs = RAW(BSM_FIELD_SCS); }
+    if (HAS(BSM_FIELD_BRAKE_BOOST)) { bsm->brakes.brake_boost_opt = true; bsm->brakes.brake_boost = RAW(BSM_FIELD_BRAKE_BOOST); }
+    if (HAS(BSM_FIELD_AUX_BRAKES))  { bsm->brakes.aux_brakes_opt = true; bsm->brakes.aux_brakes = RAW(BSM_FIELD_AUX_BRAKES); }
+    if (HAS(BSM_FIELD_VEH_WIDTH))   { bsm->veh_size.width = FROM_RAW(RAW(BSM_FIELD_VEH_WIDTH), BSM_SCALE_WIDTH_LENGTH); }
+    if (HAS(BSM_FIELD_VEH_LEN))     { bsm->veh_size.length = FROM_RAW(RAW(BSM_FIELD_VEH_LEN), BSM_SCALE_WIDTH_LENGTH); }
+    if (HAS(BSM_FIELD_VEH_HEIGHT))  { bsm->veh_size.height_opt = true; bsm->veh_size.height = FROM_RAW(RAW(BSM_FIELD_VEH_HEIGHT), BSM_SCALE_HEIGHT); }
+    if (HAS(BSM_FIELD_VEH_FUEL_TYPE)) { bsm->vehicle_classification.fuel_type_opt = true; bsm->vehicle_classification.fuel_type = RAW(BSM_FIELD_VEH_FUEL_TYPE); }
+    if (HAS(BSM_FIELD_LIGHTS))      { bsm->lights_opt = true; bsm->lights = RAW(BSM_FIELD_LIGHTS); }
+    if (HAS(BSM_FIELD_SIREN_USE))   { bsm->veh_emergency_ext_opt = true; ext->siren_use_opt = true; ext->siren_use = RAW(BSM_FIELD_SIREN_USE); }
+}
+
+const char *bsm_field_key(int field)
+{
+    return (field >= 0 && field < BSM_FIELD_COUNT) ? s_keys[field] : NULL;
+}
+
+void bsm_frame_merge(v2x_bsm_frame_struct *state, const v2x_bsm_frame_struct *delta)
+{
+    int i;
+    for (i = 0; i < BSM_FIELD_COUNT; i++)
+    {
+        if ((delta->present & BSM_FIELD_BIT(i)) == 0)
+        {
+            continue;
+        }
+        if (i == BSM_FIELD_ID)
+        {
+            memcpy(state->id, delta->id, MAX_ID_LEN);
+        }
+        else
+        {
+            state->values[i] = delta->values[i];
+        }
+    }
+    state->present |= delta->present;
+    state->seq = delta->seq;
+    state->flags = delta->flags;
+}
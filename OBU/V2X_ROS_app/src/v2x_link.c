@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "v2x_link.h"
+
+static const char s_magic[4] = { 'V', '2', 'X', 'H' };
+
+static void put32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v);
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t get32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t bit_count(uint64_t v)
+{
+    uint32_t count = 0;
+    for (; v != 0; v &= v - 1)
+    {
+        count++;
+    }
+    return count;
+}
+
+uint64_t link_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void put_link_header(char *out_buf, uint32_t seq)
+{
+    unsigned char *p = (unsigned char *)out_buf;
+    uint64_t now = link_now_ns();
+    memcpy(p, s_magic, sizeof(s_magic));
+    put32(p + 4, seq);
+    put32(p + 8, (uint32_t)now);
+    put32(p + 12, (uint32_t)(now >> 32));
+}
+
+int get_link_header(const char *in_buf, int in_len, uint32_t *seq, uint64_t *send_ns)
+{
+    const unsigned char *p = (const unsigned char *)in_buf;
+    if (in_len < LINK_HEADER_SIZE || memcmp(p, s_magic, sizeof(s_magic)) != 0)
+    {
+        return 0;
+    }
+    *seq = get32(p + 4);
+    *send_ns = (uint64_t)get32(p + 8) | ((uint64_t)get32(p + 12) << 32);
+    return LINK_HEADER_SIZE;
+}
+
+void link_monitor_receive(v2x_link_monitor_struct *monitor, uint32_t seq, uint64_t send_ns, uint64_t now_ns)
+{
+    uint32_t previous = monitor->last;
+    int32_t distance;
+    uint32_t age;
+    uint64_t bit;
+
+    monitor->received++;
+    if (now_ns >= send_ns)
+    {
+        uint64_t latency = now_ns - send_ns;
+        if (monitor->latency_count == 0 || latency < monitor->latency_min_ns)
+        {
+            monitor->latency_min_ns = latency;
+        }
+        if (latency > monitor->latency_max_ns)
+        {
+            monitor->latency_max_ns = latency;
+        }
+        monitor->latency_sum_ns += latency;
+        monitor->latency_count++;
+    }
+
+    monitor->last = seq;
+    if (!monitor->started)
+    {
+        monitor->started = 1;
+        monitor->highest = seq;
+        monitor->window = ~(uint64_t)0;    // nothing before the first datagram is missing
+        return;
+    }
+
+    distance = (int32_t)(seq - monitor->highest);
+    if (distance > 0)
+    {
+        // the numbers that leave the window and were not received are lost
+        if (distance >= LINK_WINDOW)
+        {
+            monitor->lost += (LINK_WINDOW - bit_count(monitor->window)) + (distance - LINK_WINDOW);
+            monitor->window = 1;
+        }
+        else
+        {
+            monitor->lost += distance - bit_count(monitor->window >> (LINK_WINDOW - distance));
+            monitor->window = (monitor->window << distance) | 1;
+        }
+        monitor->highest = seq;
+        return;
+    }
+
+    age = (uint32_t)(-(int64_t)distance);
+    if (age >= LINK_WINDOW)
+    {
+        if (seq == previous + 1)
+        {
+            // two in a row from before the window: the sender started again
+            monitor->highest = seq;
+            monitor->window = ~(uint64_t)0;
+        }
+        return;    // already counted as lost
+    }
+
+    bit = (uint64_t)1 << age;
+    if (monitor->window & bit)
+    {
+        monitor->duplicated++;
+        return;
+    }
+    monitor->window |= bit;
+    monitor->reordered++;
+}
+
+void link_monitor_print(const v2x_link_monitor_struct *monitor)
+{
+    printf("link: received %llu lost %llu duplicated %llu reordered %llu latency us min %llu mean %llu max %llu\n",
+           (unsigned long long)monitor->received,
+           (unsigned long long)monitor->lost,
+           (unsigned long long)monitor->duplicated,
+           (unsigned long long)monitor->reordered,
+           (unsigned long long)(monitor->latency_min_ns / 1000),
+           (unsigned long long)(monitor->latency_count > 0 ? monitor->latency_sum_ns / monitor->latency_count / 1000 : 0),
+           (unsigned long long)(monitor->latency_max_ns / 1000));
+}
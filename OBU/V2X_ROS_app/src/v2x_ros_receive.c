@@ -12,14 +12,28 @@
 #include <math.h>
 #include <cJSON.h>
 #include "v2x_includes.h"
+#include "v2x_bsm_frame.h"
+#include "v2x_shm_ring.h"
+#include "v2x_link.h"
 
 
 #define MY_RECV_PORT 6801 // port 8866 is used to receive  messages
 #define BUFF_LEN 1024
 #define WMS_PORT 7201 // WMS listening port 7201
+#define LINK_PRINT_INTERVAL 100 // print the link counters every n datagrams
 char *SERVERIP = "127.0.0.1"; // local IP
 static v2x_bsm_struct s_host_bsm;       
 static v2x_bsm_struct s_remote_bsm;     
+static v2x_link_monitor_struct s_link;  // loss, reordering and latency of the CAPL DLL link
+static v2x_bsm_frame_struct s_dll_bsm;  // full state of the CAPL DLL rebuilt from delta messages
+static int s_dll_synced = 0;            // a keyframe was received, s_dll_bsm is valid
+
+/* Number of the item 'name' of 'object', 'fallback' if there is none */
+static double get_number(const cJSON* object, const char* name, double fallback)
+{
+    const cJSON* item = cJSON_GetObjectItem(object, name);
+    return cJSON_IsNumber(item) ? item->valuedouble : fallback;
+}
 
 void send_to_wms(char* tx_buf, int tx_length)
 {
@@ -44,17 +58,176 @@ void send_to_wms(char* tx_buf, int tx_length)
 
 }
 
-int main()
+/* Builds the JSON document WMS expects from a BSM */
+static char* bsm_to_json(const v2x_bsm_struct* bsm)
+{
+    cJSON* root = cJSON_CreateObject();
+    cJSON* format;
+    cJSON_AddNumberToObject(root, "host_flag", bsm->host_flag == VEH_FLAG_HOST ? 1 : (bsm->host_flag == VEH_FLAG_REMOTE ? 2 : 0));
+    format = cJSON_AddObjectToObject(root, "pos");
+    cJSON_AddNumberToObject(format, "latitude", bsm->pos.latitude);
+    cJSON_AddNumberToObject(format, "longitude", bsm->pos.longitude);
+    cJSON_AddNumberToObject(root, "trans", bsm->trans);
+    cJSON_AddNumberToObject(root, "speed", bsm->speed);
+    cJSON_AddNumberToObject(root, "heading", bsm->heading);
+    format = cJSON_AddObjectToObject(root, "accel_set");
+    cJSON_AddNumberToObject(format, "acc_lng", bsm->accel_set.acc_lng);
+    cJSON_AddNumberToObject(format, "acc_lat", bsm->accel_set.acc_lat);
+    cJSON_AddNumberToObject(root, "vehicle_classification", bsm->vehicle_classification.classification);
+    cJSON_AddNumberToObject(root, "events", bsm->events);
+    format = cJSON_AddObjectToObject(root, "veh_emergency_ext");
+    cJSON_AddNumberToObject(format, "response_type", bsm->veh_emergency_ext.response_type);
+    cJSON_AddNumberToObject(format, "lights_use", bsm->veh_emergency_ext.lights_use);
+    char* text = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return text;
+}
+
+/* Delta mode of the CAPL DLL: a keyframe replaces the full state, any other
+   message only carries the fields changed since the previous one and is
+   merged into it. Returns 0 if s_dll_bsm holds the full state, -1 while no
+   keyframe was received yet. */
+static int merge_delta(const v2x_bsm_frame_struct* msg)
+{
+    if (msg->flags & BSM_FRAME_KEYFRAME)
+    {
+        s_dll_bsm = *msg;
+        s_dll_synced = 1;
+        return 0;
+    }
+    if (!s_dll_synced)
+    {
+        return -1;
+    }
+    if (msg->seq != s_dll_bsm.seq + 1)
+    {
+        printf("delta %u follows %u, state may be stale until the next keyframe\n", msg->seq, s_dll_bsm.seq);
+    }
+    bsm_frame_merge(&s_dll_bsm, msg);
+    return 0;
+}
+
+/* Reads a flat JSON document of the CAPL DLL into 'frame'. A document
+   without "Seq" is a full document (delta mode off) and counts as keyframe. */
+static void frame_from_json(const cJSON* root, v2x_bsm_frame_struct* frame)
+{
+    const cJSON* item;
+    int i;
+    memset(frame, 0, sizeof(*frame));
+    for (i = 0; i < BSM_FIELD_COUNT; i++)
+    {
+        item = cJSON_GetObjectItemCaseSensitive(root, bsm_field_key(i));
+        if (i == BSM_FIELD_ID && cJSON_IsString(item))
+        {
+            strncpy(frame->id, item->valuestring, MAX_ID_LEN);
+        }
+        else if (cJSON_IsString(item))
+        {
+            // text fields carry the number they contain, like the binary frame
+            frame->values[i] = (int32_t)strtol(item->valuestring, NULL, 0);
+        }
+        else if (cJSON_IsNumber(item))
+        {
+            frame->values[i] = (int32_t)item->valuedouble;
+        }
+        else
+        {
+            continue;
+        }
+        frame->present |= BSM_FIELD_BIT(i);
+    }
+    item = cJSON_GetObjectItemCaseSensitive(root, "Seq");
+    if (cJSON_IsNumber(item))
+    {
+        frame->seq = (uint32_t)item->valuedouble;
+        item = cJSON_GetObjectItemCaseSensitive(root, "Keyframe");
+        frame->flags = (cJSON_IsNumber(item) && item->valueint == 1) ? BSM_FRAME_KEYFRAME : 0;
+    }
+    else
+    {
+        frame->flags = BSM_FRAME_KEYFRAME;
+    }
+}
+
+/* Merges a message of the CAPL DLL and sends the full state to WMS */
+static void handle_dll_bsm(const v2x_bsm_frame_struct* msg)
+{
+    if (merge_delta(msg) != 0)
+    {
+        printf("delta %u dropped, waiting for the first keyframe\n", msg->seq);
+        return;
+    }
+    bsm_frame_to_struct(&s_dll_bsm, &s_host_bsm);
+    s_host_bsm.host_flag = VEH_FLAG_HOST;
+    char* json_buf = bsm_to_json(&s_host_bsm);
+    send_to_wms(json_buf, strlen(json_buf));
+    cJSON_free(json_buf);
+}
+
+/* Binary mode: decodes the frame, WMS still gets JSON */
+static void handle_bsm_frame(const char* buf, int len, int rx_count)
+{
+    v2x_bsm_frame_struct frame;
+    printf("[rx_count: %d length:%d] <bsm frame>\n", rx_count, len);
+    if (decode_bsm_frame(buf, len, &frame) != 0)
+    {
+        return;
+    }
+    handle_dll_bsm(&frame);
+}
+
+/* Reads the frames of the CAPL DLL from the shared memory ring 'name'
+   (dllSetSharedMemory) instead of UDP */
+static int receive_shm(const char* name)
+{
+    v2x_shm_ring_struct ring;
+    char receive_buf[BUFF_LEN];
+    int rx_count = 0;
+    while (v2x_shm_ring_open(&ring, name) != 0)
+    {
+        printf("waiting for shared memory ring %s\n", name);
+        sleep(1);
+    }
+    while(1)
+    {
+        int count = v2x_shm_ring_read(&ring, receive_buf, BUFF_LEN, 1000);
+        if (count <= 0)
+        {
+            continue;
+        }
+        rx_count++;
+        handle_bsm_frame(receive_buf, count, rx_count);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
 {
     int ret;
     int server_sock = -1;
     struct sockaddr_in server_addr;
+    const char *group = NULL;
+    if (argc == 3 && strcmp(argv[1], "--shm") == 0)
+    {
+        return receive_shm(argv[2]);
+    }
+    // the CAPL DLL may send to a multicast group (dllSetDestinations)
+    if (argc == 3 && strcmp(argv[1], "--multicast") == 0)
+    {
+        group = argv[2];
+    }
     // IPV4 and UDP protocol
     server_sock = socket(AF_INET, SOCK_DGRAM, 0);    
     if(server_sock < 0){
         printf("create socket failed \n");
         return -1;
     }
+    if (group != NULL)
+    {
+        // other consumers on this host listen on the same port
+        int reuse = 1;
+        setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    }
     memset(&server_addr, 0 ,sizeof server_addr);
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
@@ -66,6 +239,18 @@ int main()
         printf("socket bind failed \n");
         return -1;
     }
+    if (group != NULL)
+    {
+        struct ip_mreq mreq;
+        memset(&mreq, 0, sizeof(mreq));
+        mreq.imr_multiaddr.s_addr = inet_addr(group);
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if (setsockopt(server_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+        {
+            printf("joining multicast group %s failed \n", group);
+            return -1;
+        }
+    }
 
     //monitor the socket status per 100ms
     fd_set readfds;
@@ -101,14 +286,46 @@ int main()
                 return -1;	
             }
             rx_count++;
-            printf("[rx_count: %d length:%d] %s\n", rx_count, count, receive_buf);
+            // strip the link header of the CAPL DLL, see v2x_link.h
+            uint32_t link_seq;
+            uint64_t link_send_ns;
+            int skip = get_link_header(receive_buf, count, &link_seq, &link_send_ns);
+            char* payload = receive_buf + skip;
+            count -= skip;
+            if (skip > 0)
+            {
+                link_monitor_receive(&s_link, link_seq, link_send_ns, link_now_ns());
+                if (s_link.received % LINK_PRINT_INTERVAL == 0)
+                {
+                    link_monitor_print(&s_link);
+                }
+            }
+            if (is_bsm_frame(payload, count))
+            {
+                handle_bsm_frame(payload, count, rx_count);
+                continue;
+            }
+            printf("[rx_count: %d length:%d] %s\n", rx_count, count, payload);
             cJSON* root;
             cJSON* format;
-            root = cJSON_Parse(receive_buf);
+            root = cJSON_Parse(payload);
+            if (root == NULL)
+            {
+                printf("invalid json\n");
+                continue;
+            }
+            // the flat documents of the CAPL DLL (JSON wire format, maybe
+            // delta mode) carry no host_flag, WMS documents are nested
+            if (!cJSON_HasObjectItem(root, "host_flag"))
+            {
+                v2x_bsm_frame_struct frame;
+                frame_from_json(root, &frame);
+                cJSON_Delete(root);
+                handle_dll_bsm(&frame);
+                continue;
+            }
             int value_int;
-            double value_double;
-            char* value_string;
-            value_int = cJSON_GetObjectItem(root, "host_flag")->valueint;
+            value_int = (int)get_number(root, "host_flag", 0);
             if (value_int == 1)
             {
                 s_host_bsm.host_flag = VEH_FLAG_HOST;
@@ -122,34 +339,24 @@ int main()
                 s_host_bsm.host_flag = VEH_FLAG_NONE;
             }
             format = cJSON_GetObjectItem(root, "pos");
-            value_double = cJSON_GetObjectItem(format, "latitude")->valuedouble;
-            s_host_bsm.pos.latitude = value_double;
-            value_double = cJSON_GetObjectItem(format, "longitude")->valuedouble;
-            s_host_bsm.pos.longitude = value_double;
-            value_int = cJSON_GetObjectItem(root, "trans")->valueint;
-            s_host_bsm.trans = value_int;
-            value_double = cJSON_GetObjectItem(root, "speed")->valuedouble;
-            s_host_bsm.speed = value_double;
-            value_double = cJSON_GetObjectItem(root, "heading")->valuedouble;
-            s_host_bsm.heading = value_double;
+            s_host_bsm.pos.latitude = get_number(format, "latitude", 0);
+            s_host_bsm.pos.longitude = get_number(format, "longitude", 0);
+            s_host_bsm.trans = (int)get_number(root, "trans", 0);
+            s_host_bsm.speed = get_number(root, "speed", 0);
+            s_host_bsm.heading = get_number(root, "heading", 0);
             format = cJSON_GetObjectItem(root, "accel_set");
-            value_double = cJSON_GetObjectItem(format, "acc_lng")->valuedouble;
-            s_host_bsm.accel_set.acc_lng = value_double;
-            value_double = cJSON_GetObjectItem(format, "acc_lat")->valuedouble;
-            s_host_bsm.accel_set.acc_lat = value_double;
-            value_int = cJSON_GetObjectItem(root, "vehicle_classification")->valueint;
-            s_host_bsm.vehicle_classification.classification = value_int;
-            value_int = cJSON_GetObjectItem(root, "events")->valueint;
-            s_host_bsm.events = value_int;
+            s_host_bsm.accel_set.acc_lng = get_number(format, "acc_lng", 0);
+            s_host_bsm.accel_set.acc_lat = get_number(format, "acc_lat", 0);
+            s_host_bsm.vehicle_classification.classification = (int)get_number(root, "vehicle_classification", 0);
+            s_host_bsm.events = (int)get_number(root, "events", 0);
             format = cJSON_GetObjectItem(root, "veh_emergency_ext");
-            value_int = cJSON_GetObjectItem(format, "response_type")->valueint;
-            s_host_bsm.veh_emergency_ext.response_type = value_int;
-            value_int = cJSON_GetObjectItem(format, "lights_use")->valueint;
-            s_host_bsm.veh_emergency_ext.lights_use = value_int;
+            s_host_bsm.veh_emergency_ext.response_type = (int)get_number(format, "response_type", 0);
+            s_host_bsm.veh_emergency_ext.lights_use = (int)get_number(format, "lights_use", 0);
          
             //V2X_PR(LOG_LEVEL_DEBUG,LOG_ID,"[rx_count: %d length:%d] %s", rx_count, count, receive_buf);
             // send message to wms
-            send_to_wms(receive_buf,count);
+            send_to_wms(payload,count);
+            cJSON_Delete(root);
             //V2X_PR(LOG_LEVEL_DEBUG,LOG_ID,"Sending to WMS");
         }
         else if(FD_ISSET(server_sock, &readfds)==0)
@@ -12,6 +12,8 @@
 #include <math.h>
 #include "v2x_includes.h"
 #include <cJSON.h>
+#include "v2x_bsm_frame.h"
+#include "v2x_link.h"
 
 #define MY_SEND_PORT 6800 // canoe listening port
 #define BUFF_LEN 1024
@@ -24,11 +26,15 @@ char recvbuf[BUFF_LEN] = {0};
 char sendbuf[BUFF_LEN] = {0};
 static v2x_bsm_struct s_host_bsm;       
 static v2x_bsm_struct s_remote_bsm;     
+static int s_binary_mode = 0;           // -b: send binary BSM frames instead of JSON
+static int s_link_header = 0;           // -l: put a link header in front of every datagram
 
 void send_to_ros(char* tx_buf, int tx_length)
 {
     struct sockaddr_in servaddr;
     static int tx_count = 0;
+    static uint32_t link_seq = 0;
+    char packet[LINK_HEADER_SIZE + BUFF_LEN];
     int cli_sock = -1;
     cli_sock = socket(PF_INET, SOCK_DGRAM, 0);
     // if((cli_sock = socket(PF_INET, SOCK_DGRAM, 0)) < 0)
@@ -41,18 +47,43 @@ void send_to_ros(char* tx_buf, int tx_length)
     servaddr.sin_port        = htons(MY_SEND_PORT);
     servaddr.sin_addr.s_addr = inet_addr(ROS_SERVER_IP_ADDR);
 
-    printf("send data to ros:[tx_count: %d length:%d] %s\n",tx_count, tx_length, tx_buf);
-    sendto(cli_sock, tx_buf, tx_length, 0, (struct sockaddr *)&servaddr, sizeof(servaddr));
+    printf("send data to ros:[tx_count: %d length:%d] %s\n",tx_count, tx_length, is_bsm_frame(tx_buf, tx_length) ? "<bsm frame>" : tx_buf);
+    if (s_link_header)
+    {
+        // link header with sequence number and send time, see v2x_link.h
+        put_link_header(packet, link_seq);
+        memcpy(packet + LINK_HEADER_SIZE, tx_buf, tx_length);
+        if (sendto(cli_sock, packet, LINK_HEADER_SIZE + tx_length, 0, (struct sockaddr *)&servaddr, sizeof(servaddr)) >= 0)
+        {
+            link_seq++;
+        }
+    }
+    else
+    {
+        sendto(cli_sock, tx_buf, tx_length, 0, (struct sockaddr *)&servaddr, sizeof(servaddr));
+    }
     tx_count += 1;
     close(cli_sock);
 
 }
 
 
-int main()
+int main(int argc, char *argv[])
 {
     int ret;
     int server_sock = -1;
+    int i;
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-b") == 0)
+        {
+            s_binary_mode = 1;
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            s_link_header = 1;
+        }
+    }
     struct sockaddr_in server_addr;
     // IPV4 and UDP protocol
     server_sock = socket(AF_INET, SOCK_DGRAM, 0);    
@@ -153,8 +184,21 @@ int main()
             s_remote_bsm.veh_emergency_ext.lights_use = value_int;
 
 
-            // send message to wms
-            send_to_ros(receive_buf,count);
+            // send message to ros
+            if (s_binary_mode)
+            {
+                static uint32_t tx_seq = 0;
+                v2x_bsm_frame_struct frame;
+                char frame_buf[BSM_FRAME_SIZE];
+                bsm_frame_from_struct(&s_remote_bsm, &frame);
+                frame.seq = tx_seq++;
+                frame.flags = BSM_FRAME_KEYFRAME;
+                send_to_ros(frame_buf, encode_bsm_frame(&frame, frame_buf, sizeof(frame_buf)));
+            }
+            else
+            {
+                send_to_ros(receive_buf,count);
+            }
             //V2X_PR(LOG_LEVEL_DEBUG,LOG_ID,"Sending to WMS");
         }
         else if(FD_ISSET(server_sock, &readfds)==0)
@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "v2x_shm_ring.h"
+
+#define SHM_HEADER_SIZE     256
+#define SHM_OFF_SLOT_SIZE   8
+#define SHM_OFF_SLOT_COUNT  12
+#define SHM_OFF_DROPPED     16
+#define SHM_OFF_HEAD        64
+#define SHM_OFF_WAITERS     68
+#define SHM_OFF_TAIL        128
+
+static const char s_magic[4] = { 'V', '2', 'X', 'R' };
+
+static uint32_t *word(const v2x_shm_ring_struct *ring, int offset)
+{
+    return (uint32_t *)(ring->base + offset);
+}
+
+int v2x_shm_ring_open(v2x_shm_ring_struct *ring, const char *name)
+{
+    char path[256];
+    struct stat info;
+    unsigned char *base;
+    uint32_t magic;
+    int fd;
+
+    memset(ring, 0, sizeof(*ring));
+    snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/", name);
+    fd = shm_open(path, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (fstat(fd, &info) != 0 || info.st_size < SHM_HEADER_SIZE)
+    {
+        close(fd);
+        return -1;
+    }
+    base = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return -1;
+    }
+    ring->base = base;
+    ring->size = info.st_size;
+
+    // the writer sets the magic last
+    magic = __atomic_load_n(word(ring, 0), __ATOMIC_ACQUIRE);
+    if (memcmp(&magic, s_magic, sizeof(s_magic)) != 0
+        || *word(ring, 4) != V2X_SHM_RING_VERSION
+        || SHM_HEADER_SIZE + (unsigned long)*word(ring, SHM_OFF_SLOT_SIZE) * *word(ring, SHM_OFF_SLOT_COUNT) > ring->size)
+    {
+        v2x_shm_ring_close(ring);
+        return -1;
+    }
+    return 0;
+}
+
+// sleeps until head differs from 'head', at most timeout_ms (-1: forever)
+static void wait_head(v2x_shm_ring_struct *ring, uint32_t head, int timeout_ms)
+{
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+    // set 'waiters' before the last look at head, the writer checks it after
+    // publishing a frame
+    __atomic_store_n(word(ring, SHM_OFF_WAITERS), 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(word(ring, SHM_OFF_HEAD), __ATOMIC_SEQ_CST) == head)
+    {
+        syscall(SYS_futex, word(ring, SHM_OFF_HEAD), FUTEX_WAIT, head,
+                timeout_ms < 0 ? NULL : &timeout, NULL, 0);
+    }
+    __atomic_store_n(word(ring, SHM_OFF_WAITERS), 0, __ATOMIC_SEQ_CST);
+}
+
+int v2x_shm_ring_read(v2x_shm_ring_struct *ring, char *out_buf, int out_len, int timeout_ms)
+{
+    uint32_t slot_size = *word(ring, SHM_OFF_SLOT_SIZE);
+    uint32_t slot_count = *word(ring, SHM_OFF_SLOT_COUNT);
+    uint32_t tail = __atomic_load_n(word(ring, SHM_OFF_TAIL), __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(word(ring, SHM_OFF_HEAD), __ATOMIC_ACQUIRE);
+    const unsigned char *slot;
+    uint32_t length;
+
+    if (head == tail && timeout_ms != 0)
+    {
+        wait_head(ring, head, timeout_ms);
+        head = __atomic_load_n(word(ring, SHM_OFF_HEAD), __ATOMIC_ACQUIRE);
+    }
+    if (head == tail)
+    {
+        return 0;
+    }
+    if (head - tail > slot_count)
+    {
+        // cannot happen with one writer that honours tail, resync anyway
+        ring->lost += head - tail;
+        __atomic_store_n(word(ring, SHM_OFF_TAIL), head, __ATOMIC_RELEASE);
+        return 0;
+    }
+
+    slot = ring->base + SHM_HEADER_SIZE + (unsigned long)(tail & (slot_count - 1)) * slot_size;
+    memcpy(&length, slot + 4, 4);
+    if (length > slot_size - 8 || (int)length > out_len)
+    {
+        __atomic_store_n(word(ring, SHM_OFF_TAIL), tail + 1, __ATOMIC_RELEASE);
+        return -1;
+    }
+    memcpy(out_buf, slot + 8, length);
+    // the slot may be reused from now on
+    __atomic_store_n(word(ring, SHM_OFF_TAIL), tail + 1, __ATOMIC_RELEASE);
+    return (int)length;
+}
+
+uint32_t v2x_shm_ring_dropped(const v2x_shm_ring_struct *ring)
+{
+    return __atomic_load_n(word(ring, SHM_OFF_DROPPED), __ATOMIC_RELAXED);
+}
+
+void v2x_shm_ring_close(v2x_shm_ring_struct *ring)
+{
+    if (ring->base != NULL)
+    {
+        munmap(ring->base, ring->size);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
@@ -3,6 +3,9 @@
 import rospy
 import json
 import socket
+import v2x_frame
+import v2x_link
+import v2x_shm_ring
 from v2x_ros_driver.msg import V2X
 
 
@@ -14,13 +17,54 @@ def talker():
     pub = rospy.Publisher('V2X_msg', V2X, queue_size=50)
     rospy.init_node('talker', anonymous=True)
     rate = rospy.Rate(1) # 10hz
-    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
-    s.bind(dest_addr)
+    # a CAPL DLL on the same host may write binary frames into a shared
+    # memory ring instead of sending UDP (dllSetSharedMemory)
+    ring_name = rospy.get_param('~shm_ring', '')
+    if ring_name:
+        ring = v2x_shm_ring.Ring(ring_name)
+    else:
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        # the CAPL DLL may send to a multicast group (dllSetDestinations),
+        # then several consumers on this host share the port
+        group = rospy.get_param('~multicast_group', '')
+        if group:
+            s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        s.bind(dest_addr)
+        if group:
+            mreq = socket.inet_aton(group) + socket.inet_aton(rospy.get_param('~multicast_interface', '0.0.0.0'))
+            s.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+    last_seq = None
+    link = v2x_link.Monitor()
     while not rospy.is_shutdown():
-        #receive less than 1024 Byte
-        msg, addr = s.recvfrom(1024)
-        msg = msg.decode('utf-8')
-        f = json.loads(msg)
+        if ring_name:
+            msg = ring.read(timeout=1.0)
+            if msg is None:
+                continue
+        else:
+            #receive less than 1024 Byte
+            msg, addr = s.recvfrom(1024)
+            link_seq, send_ns, msg = v2x_link.unpack(msg)
+            if link_seq is not None:
+                link.receive(link_seq, send_ns)
+                rospy.loginfo_throttle(10, "V2X link: %s", link)
+        if v2x_frame.is_frame(msg):
+            try:
+                seq, flags, f = v2x_frame.decode(msg)
+            except ValueError as e:
+                rospy.logwarn_throttle(10, "V2X: %s", e)
+                continue
+            f["Seq"] = seq
+            f["Keyframe"] = flags & v2x_frame.KEYFRAME
+        else:
+            msg = msg.decode('utf-8')
+            f = json.loads(msg)
+        # delta mode: between two keyframes only the changed fields are sent,
+        # msg_to_send keeps the merged full state
+        if "Seq" in f:
+            seq = f["Seq"]
+            if f.get("Keyframe") != 1 and last_seq is not None and seq != last_seq + 1:
+                rospy.logwarn("V2X delta %d follows %d, state may be stale until the next keyframe", seq, last_seq)
+            last_seq = seq
         if "Latitude" in f:
             msg_to_send.latitude=f["Latitude"]
         if "Longtitude" in f:
@@ -3,8 +3,14 @@ import rospy
 import json
 from v2x_ros_driver.msg import V2X
 import socket
+import v2x_frame
+import v2x_link
+
+# sequence number of the next datagram, see v2x_link.py
+link_seq = 0
 
 def callback(data):
+    global link_seq
     host = '192.168.105.209'
     port = 9999
     dest_addr = (host, port)
@@ -14,8 +20,15 @@ def callback(data):
     dict_var["Longtitude"] = data.longtitude
     dict_var["Speed"] = data.speed
     dict_var["Heading"] = data.heading
-    msg = json.dumps(dict_var)
-    udp_socket.sendto(msg.encode('utf-8'), dest_addr)
+    if rospy.get_param('~binary', False):
+        msg = v2x_frame.encode(dict_var)
+    else:
+        msg = json.dumps(dict_var).encode('utf-8')
+    # the link header is opt-in, consumers like WMS expect the bare document
+    if rospy.get_param('~link_header', False):
+        msg = v2x_link.pack(link_seq, msg)
+        link_seq += 1
+    udp_socket.sendto(msg, dest_addr)
     udp_socket.close()
     #rospy.loginfo(rospy.get_caller_id() + "I heard %s", data.latitude)
     
@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+# Binary BSM frame exchanged with the CAPL DLL and the OBU bridge.
+# The layout is described in CAPLdll/CAPLdll/Sources/v2x_frame.h.
+import re
+import struct
+
+try:
+    _STRING_TYPES = basestring  # Python 2, unicode from rospy included
+except NameError:
+    _STRING_TYPES = str
+
+MAGIC = b'V2XB'
+VERSION = 1
+KEYFRAME = 0x01
+
+# JSON keys of the fields, in frame order
+KEYS = ["Latitude", "Longtitude", "Transmission", "Speed", "Heading",
+        "Acc_Lat", "Acc_Lng", "Veh_Class", "Events", "Response_Type",
+        "Lights_Use", "Id", "time_stamp", "Elevation", "Smajor_dev",
+        "Sminor_dev", "Smajor_Orien", "Pos_Confidence_Pos", "Pos_Confidence_Ele", "Wheel_Angle",
+        "Acc_Vert", "Yaw_Rate", "Brake_Padel", "Wheel_Brakes", "Traction",
+        "ABS", "SCS", "Brake_Boost", "Aux_Brakes", "Veh_Width",
+        "Veh_Len", "Veh_Height", "Veh_Fuel_Type", "Lights", "Siren_Use"]
+# fields that are strings in V2X.msg
+STRING_KEYS = ("Events", "Wheel_Brakes", "Lights")
+ID_INDEX = KEYS.index("Id")
+
+_HEADER = struct.Struct('<4sBBHIQ')
+_FIELDS = struct.Struct('<11i8s23i')
+SIZE = _HEADER.size + _FIELDS.size
+
+
+# numeric prefix as taken by strtol(text, NULL, 0)
+_NUMBER = re.compile(r'\s*([+-]?)(0[xX][0-9a-fA-F]+|0[0-7]*|[1-9][0-9]*)')
+
+
+def _to_int32(value):
+    """Like the (int32_t) cast of the C++ side, wraps instead of raising in struct.pack."""
+    value = int(value) & 0xffffffff
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def _parse_int(text):
+    """Number a text field contains, 0 if it does not start with one (e.g. "veh-01")."""
+    match = _NUMBER.match(text)
+    if match is None:
+        return 0
+    sign, digits = match.groups()
+    if digits[:2] in ('0x', '0X'):
+        value = int(digits[2:], 16)
+    else:
+        value = int(digits, 8 if digits.startswith('0') else 10)
+    return -value if sign == '-' else value
+
+
+def is_frame(data):
+    return len(data) >= SIZE and data[:4] == MAGIC
+
+
+def decode(data):
+    """Returns (seq, flags, fields), fields holds the present fields keyed like the JSON document.
+    Raises ValueError for a version this decoder does not know, later versions only append data."""
+    magic, version, flags, reserved, seq, present = _HEADER.unpack_from(data)
+    if version < VERSION:
+        raise ValueError("unknown BSM frame version %d" % version)
+    values = _FIELDS.unpack_from(data, _HEADER.size)
+    fields = {}
+    for i, key in enumerate(KEYS):
+        if present & (1 << i):
+            value = values[i]
+            if i == ID_INDEX:
+                value = value.rstrip(b'\0').decode('ascii', 'replace')
+            elif key in STRING_KEYS:
+                value = str(value)
+            fields[key] = value
+    return seq, flags, fields
+
+
+def encode(fields, seq=0, flags=KEYFRAME):
+    """Builds a frame from the fields present in 'fields', keyed like the JSON document."""
+    present = 0
+    values = []
+    for i, key in enumerate(KEYS):
+        value = fields.get(key)
+        if value is not None:
+            present |= 1 << i
+        if i == ID_INDEX:
+            values.append(str(value or '').encode('ascii')[:8])
+        elif isinstance(value, _STRING_TYPES):
+            values.append(_to_int32(_parse_int(value)))
+        else:
+            values.append(_to_int32(value or 0))
+    return _HEADER.pack(MAGIC, VERSION, flags, 0, seq, present) + _FIELDS.pack(*values)
@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+# Link header in front of the UDP datagrams exchanged with the CAPL DLL and
+# the OBU bridge: magic "V2XH", sequence number, monotonic send time in ns.
+# The layout is described in CAPLdll/CAPLdll/Sources/v2x_link.h. The send
+# time is only comparable with the receive time on the same host.
+import struct
+import time
+
+MAGIC = b'V2XH'
+WINDOW = 64
+
+_HEADER = struct.Struct('<4sIQ')
+SIZE = _HEADER.size
+_ALL = (1 << WINDOW) - 1
+
+_monotonic = getattr(time, 'monotonic', time.time)
+
+
+def now_ns():
+    return int(_monotonic() * 1e9)
+
+
+def pack(seq, payload):
+    """Returns 'payload' behind the header of datagram 'seq'."""
+    return _HEADER.pack(MAGIC, seq & 0xffffffff, now_ns()) + payload
+
+
+def unpack(data):
+    """Returns (seq, send_ns, payload), seq is None if 'data' has no header."""
+    if len(data) < SIZE or data[:4] != MAGIC:
+        return None, None, data
+    magic, seq, send_ns = _HEADER.unpack_from(data)
+    return seq, send_ns, data[SIZE:]
+
+
+class Monitor(object):
+    """Loss, duplicates, reordering and latency of one sender, see V2XLinkMonitor.
+
+    lost: not received before WINDOW newer datagrams arrived, duplicated:
+    received twice within the window, reordered: received after a newer
+    datagram within the window. Two consecutive datagrams from before the
+    window restart the sender.
+    """
+
+    def __init__(self):
+        self.received = 0
+        self.lost = 0
+        self.duplicated = 0
+        self.reordered = 0
+        self.latency_min = None
+        self.latency_max = 0
+        self._latency_sum = 0
+        self._latency_count = 0
+        self._highest = None
+        self._last = None
+        self._window = 0
+
+    def receive(self, seq, send_ns, now=None):
+        now = now_ns() if now is None else now
+        self.received += 1
+        if now >= send_ns:
+            latency = now - send_ns
+            self.latency_min = latency if self.latency_min is None else min(self.latency_min, latency)
+            self.latency_max = max(self.latency_max, latency)
+            self._latency_sum += latency
+            self._latency_count += 1
+
+        previous, self._last = self._last, seq
+        if self._highest is None:
+            self._highest = seq
+            self._window = _ALL   # nothing before the first datagram is missing
+            return
+        distance = (seq - self._highest) & 0xffffffff
+        if distance == 0 or distance >= 0x80000000:
+            age = (self._highest - seq) & 0xffffffff
+            if age >= WINDOW:
+                if seq == (previous + 1) & 0xffffffff:
+                    # two in a row from before the window: the sender started again
+                    self._highest = seq
+                    self._window = _ALL
+                return        # already counted as lost
+            if self._window & (1 << age):
+                self.duplicated += 1
+            else:
+                self._window |= 1 << age
+                self.reordered += 1
+            return
+        # the numbers that leave the window and were not received are lost
+        if distance >= WINDOW:
+            self.lost += WINDOW - bin(self._window).count('1') + distance - WINDOW
+            self._window = 1
+        else:
+            self.lost += distance - bin(self._window >> (WINDOW - distance)).count('1')
+            self._window = ((self._window << distance) | 1) & _ALL
+        self._highest = seq
+
+    def __str__(self):
+        mean = self._latency_sum // self._latency_count if self._latency_count else 0
+        return "received %d lost %d duplicated %d reordered %d latency us min %d mean %d max %d" % (
+            self.received, self.lost, self.duplicated, self.reordered,
+            (self.latency_min or 0) // 1000, mean // 1000, self.latency_max // 1000)
@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+# Reader of the shared memory ring written by the CAPL DLL (dllSetSharedMemory).
+# The layout is described in CAPLdll/CAPLdll/Sources/v2x_shm.h, the C reader
+# is OBU/V2X_ROS_app/src/v2x_shm_ring.c. Python has no futex, so read() polls.
+import mmap
+import os
+import struct
+import time
+
+MAGIC = b'V2XR'
+VERSION = 1
+
+_HEADER_SIZE = 256
+_OFF_DROPPED = 16
+_OFF_HEAD = 64
+_OFF_TAIL = 128
+_GEOMETRY = struct.Struct('<4sIII')
+_U32 = struct.Struct('<I')
+_SLOT = struct.Struct('<II')
+_POLL_INTERVAL = 0.0005
+
+
+class Ring(object):
+    def __init__(self, name):
+        fd = os.open('/dev/shm/' + name.lstrip('/'), os.O_RDWR)
+        try:
+            self._map = mmap.mmap(fd, 0)
+        finally:
+            os.close(fd)
+        magic, version, self._slot_size, self._slot_count = _GEOMETRY.unpack_from(self._map, 0)
+        if magic != MAGIC or version != VERSION:
+            self._map.close()
+            raise ValueError("%s is no V2X ring of version %d" % (name, VERSION))
+
+    def _get(self, offset):
+        return _U32.unpack_from(self._map, offset)[0]
+
+    def dropped(self):
+        """Frames the writer dropped because the ring was full."""
+        return self._get(_OFF_DROPPED)
+
+    def read(self, timeout=None):
+        """Returns the next frame as bytes, None if none arrived within 'timeout' seconds."""
+        deadline = None if timeout is None else time.time() + timeout
+        tail = self._get(_OFF_TAIL)
+        while self._get(_OFF_HEAD) == tail:
+            if deadline is not None and time.time() >= deadline:
+                return None
+            time.sleep(_POLL_INTERVAL)
+        slot = _HEADER_SIZE + (tail & (self._slot_count - 1)) * self._slot_size
+        seq, length = _SLOT.unpack_from(self._map, slot)
+        frame = bytes(self._map[slot + _SLOT.size:slot + _SLOT.size + min(length, self._slot_size - _SLOT.size)])
+        # the slot may be reused from now on
+        _U32.pack_into(self._map, _OFF_TAIL, (tail + 1) & 0xffffffff)
+        return frame
+
+    def close(self):
+        self._map.close()